@@ -0,0 +1,271 @@
+/*
+** Binary Graph Module
+** Loading maps the file read only and points the graph's CSR arrays into
+** the mapping, so there is nothing to parse or copy. The offsets and
+** targets are always checked to describe a graph the searches can walk,
+** one pass over each; the checksum, which reads every page, only when
+** asked for.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "graph.h"
+#include "bingraph.h"
+
+#define CHECKSUM_INIT 0xcbf29ce484222325ULL
+
+// the streaming writer flushes in pieces of this many bytes, a multiple
+// of 8 so the checksum can be carried from one piece to the next
+#define WRITER_BUF_BYTES (1 << 20)
+
+/*
+** 64-bit checksum over n bytes, eight bytes at a time (FNV-1a style
+** mixing of words, then of any trailing bytes)
+*/
+uint64_t
+bingraph_checksum(const void *data, size_t n) {
+    return bingraph_checksum_update(CHECKSUM_INIT, data, n);
+}
+
+/*
+** Carry checksum h on over n more bytes. Checksumming a block in pieces
+** gives the same result as in one go as long as every piece but the last
+** is a multiple of 8 bytes long.
+*/
+uint64_t
+bingraph_checksum_update(uint64_t h, const void *data, size_t n) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t w;
+    size_t i;
+    for (i=0;i+8<=n;i+=8) {
+        memcpy(&w, p + i, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    for (;i<n;i++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/*
+** Does the file start with the binary graph magic?
+*/
+int
+bingraph_is_file(const char *filename) {
+    char magic[8];
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    int is = fread(magic, 1, 8, fp) == 8 && memcmp(magic, BINGRAPH_MAGIC, 8) == 0;
+    fclose(fp);
+    return is;
+}
+
+/*
+** Why the CSR arrays of nv vertices and m edges cannot be searched, or
+** NULL if the offsets never go back and every target is a vertex
+*/
+static const char
+*bingraph_check_csr(const EdgeIndex *offsets, const Label *targets, int64_t nv, int64_t m) {
+    if (offsets[0] != 0 || offsets[nv] != m) {
+        return "corrupt offsets";
+    }
+    for (int64_t v = 0; v < nv; v++) {
+        if (offsets[v+1] < offsets[v]) {
+            return "corrupt offsets";
+        }
+    }
+    for (int64_t e = 0; e < m; e++) {
+        if (targets[e] < 0 || targets[e] >= nv) {
+            return "edge to a vertex out of range";
+        }
+    }
+    return NULL;
+}
+
+/*
+** Map a binary graph file and return a frozen graph whose CSR arrays live
+** in the mapping. Returns NULL (after saying why) if the file is not a
+** valid graph of this build's label, distance and edge index widths.
+*/
+Graph
+*bingraph_load(const char *filename, int verify) {
+    struct stat st;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(filename);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+    size_t n = st.st_size;
+    if (n < sizeof(bingraph_header_t)) {
+        fprintf(stderr, "ERROR! %s: too short for a binary graph\n", filename);
+        close(fd);
+        return NULL;
+    }
+    char *buf = (char *)mmap(NULL, n, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (buf == MAP_FAILED) {
+        perror(filename);
+        return NULL;
+    }
+
+    bingraph_header_t hd;
+    memcpy(&hd, buf, sizeof(hd));
+    const char *why = NULL;
+    int64_t nv = (int64_t)hd.H + hd.S;
+    uint32_t offset_bytes = hd.offset_bytes ? hd.offset_bytes : 4;
+    if (memcmp(hd.magic, BINGRAPH_MAGIC, 8) != 0) {
+        why = "not a binary graph";
+    } else if (hd.version != BINGRAPH_VERSION) {
+        why = "unsupported format version";
+    } else if (hd.label_bytes != sizeof(Label) || hd.distance_bytes != sizeof(Distance)) {
+        why = "written with different label or distance widths";
+    } else if (hd.header_bytes != sizeof(hd) || hd.H < 0 || hd.S < 0
+               || nv <= 0 || nv > LABEL_MAX || hd.num_edges < 0) {
+        why = "corrupt header";
+    } else if (offset_bytes != sizeof(EdgeIndex) || hd.num_edges > EDGE_INDEX_MAX) {
+        why = offset_bytes == 8 ? "needs a build with EDGE_BITS=64"
+                                : "written with a different edge index width";
+    } else if (n != sizeof(hd) + sizeof(EdgeIndex) * (nv + 1)
+                    + (sizeof(Label) + sizeof(Distance)) * (uint64_t)hd.num_edges) {
+        why = "file size does not match the header";
+    }
+    EdgeIndex *offsets = (EdgeIndex *)(buf + sizeof(hd));
+    if (why == NULL) {
+        why = bingraph_check_csr(offsets, (Label *)(offsets + nv + 1), nv, hd.num_edges);
+    }
+    if (why == NULL && verify
+        && bingraph_checksum(buf + sizeof(hd), n - sizeof(hd)) != hd.checksum) {
+        why = "checksum mismatch";
+    }
+    if (why) {
+        fprintf(stderr, "ERROR! %s: %s\n", filename, why);
+        munmap(buf, n);
+        return NULL;
+    }
+
+    Graph *g = graph_new((int)nv);
+    g->H = hd.H;
+    g->S = hd.S;
+    g->num_edges = (EdgeIndex)hd.num_edges;
+    g->offsets = offsets;
+    g->targets = (Label *)(offsets + nv + 1);
+    g->weights = (Distance *)(g->targets + hd.num_edges);
+    g->mapped = buf;
+    g->mapped_bytes = n;
+    return g;
+}
+
+/*
+** Write a frozen graph in the binary format, through the streaming writer
+** so the arrays are checksummed a buffer at a time rather than copied.
+** return 1 on success, 0 on fail
+*/
+int
+bingraph_save(Graph *g, const char *filename) {
+    assert(g && g->offsets);
+    int nv = g->number_of_vertices;
+    bingraph_writer_t *w = bingraph_writer_open(filename, g->H, g->S, g->num_edges);
+    if (w == NULL) {
+        return 0;
+    }
+    int ok = bingraph_writer_put(w, g->offsets, sizeof(EdgeIndex) * (nv + 1))
+          && bingraph_writer_put(w, g->targets, sizeof(Label) * g->num_edges)
+          && bingraph_writer_put(w, g->weights, sizeof(Distance) * g->num_edges);
+    return bingraph_writer_close(w) && ok;
+}
+
+/*
+** Start writing a binary graph of H houses, S schools and num_edges
+** directed edges; the arrays then go in with bingraph_writer_put, offsets
+** first. Returns NULL (after saying why) if the file cannot be created.
+*/
+bingraph_writer_t
+*bingraph_writer_open(const char *filename, int H, int S, int64_t num_edges) {
+    bingraph_writer_t *w = (bingraph_writer_t *)calloc(1, sizeof(bingraph_writer_t));
+    assert(w);
+    w->buf = (unsigned char *)malloc(WRITER_BUF_BYTES);
+    assert(w->buf);
+    memcpy(w->hd.magic, BINGRAPH_MAGIC, 8);
+    w->hd.version = BINGRAPH_VERSION;
+    w->hd.header_bytes = sizeof(bingraph_header_t);
+    w->hd.label_bytes = sizeof(Label);
+    w->hd.distance_bytes = sizeof(Distance);
+    w->hd.offset_bytes = sizeof(EdgeIndex);
+    w->hd.H = H;
+    w->hd.S = S;
+    w->hd.num_edges = num_edges;
+    w->checksum = CHECKSUM_INIT;
+    w->expected = sizeof(EdgeIndex) * ((uint64_t)H + S + 1)
+                + (sizeof(Label) + sizeof(Distance)) * (uint64_t)num_edges;
+    // a zero header holds the place of the real one until the close
+    w->fp = fopen(filename, "wb");
+    if (w->fp == NULL || fwrite(&w->hd, sizeof(w->hd), 1, w->fp) != 1) {
+        perror(filename);
+        if (w->fp) {
+            fclose(w->fp);
+        }
+        free(w->buf);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+static int
+writer_flush(bingraph_writer_t *w) {
+    w->checksum = bingraph_checksum_update(w->checksum, w->buf, w->n);
+    int ok = fwrite(w->buf, 1, w->n, w->fp) == w->n;
+    w->n = 0;
+    return ok;
+}
+
+/*
+** Append n bytes of the arrays. return 1 on success, 0 on fail
+*/
+int
+bingraph_writer_put(bingraph_writer_t *w, const void *data, size_t n) {
+    const unsigned char *p = (const unsigned char *)data;
+    w->written += n;
+    while (n > 0) {
+        size_t k = WRITER_BUF_BYTES - w->n < n ? WRITER_BUF_BYTES - w->n : n;
+        memcpy(w->buf + w->n, p, k);
+        w->n += k;
+        p += k;
+        n -= k;
+        if (w->n == WRITER_BUF_BYTES && !writer_flush(w)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+** Finish the file, writing the real header, and free the writer.
+** return 1 if the arrays were exactly as long as the header says and
+** everything was written, 0 otherwise
+*/
+int
+bingraph_writer_close(bingraph_writer_t *w) {
+    int ok = writer_flush(w) && w->written == w->expected;
+    w->hd.checksum = w->checksum;
+    ok = ok && fseek(w->fp, 0, SEEK_SET) == 0
+            && fwrite(&w->hd, sizeof(w->hd), 1, w->fp) == 1;
+    if (fclose(w->fp) != 0) {
+        ok = 0;
+    }
+    free(w->buf);
+    free(w);
+    return ok;
+}
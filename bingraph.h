@@ -0,0 +1,52 @@
+/*
+** Binary Graph Module - header file
+** A versioned file holding the header counts and the CSR arrays, laid out
+** so the solver can map it read only and use the arrays in place:
+**
+**   header (64 bytes, see bingraph_header_t)
+**   offsets[number_of_vertices+1]   EdgeIndex
+**   targets[num_edges]              Label
+**   weights[num_edges]              Distance
+**
+** All values are in the byte order of the machine that wrote the file.
+*/
+#include <stdint.h>
+
+#define BINGRAPH_MAGIC   "DSCGRAPH"
+#define BINGRAPH_VERSION 1
+
+typedef struct {
+    char     magic[8];		// BINGRAPH_MAGIC, not NUL terminated
+    uint32_t version;		// BINGRAPH_VERSION
+    uint32_t header_bytes;	// sizeof(bingraph_header_t), where the arrays start
+    uint32_t label_bytes;	// sizeof(Label) of the writer
+    uint32_t distance_bytes;	// sizeof(Distance) of the writer
+    int32_t  H;			// number of houses
+    int32_t  S;			// number of schools
+    int64_t  num_edges;		// number of directed edges in the CSR arrays
+    uint64_t checksum;		// bingraph_checksum() of everything after the header
+    uint32_t offset_bytes;	// sizeof(EdgeIndex) of the writer, 0 in older files for 4
+    uint8_t  reserved[12];	// zero
+} bingraph_header_t;
+
+// writes a binary graph whose arrays are produced in order, a piece at a
+// time, without holding them: the header goes in last, once the
+// checksum is known
+typedef struct {
+    FILE *fp;
+    bingraph_header_t hd;
+    uint64_t checksum;		// over the bytes flushed so far
+    uint64_t expected;		// bytes the arrays take, from the header counts
+    uint64_t written;
+    size_t n;			// bytes in buf
+    unsigned char *buf;
+} bingraph_writer_t;
+
+int    bingraph_is_file(const char *filename);		// does the file start with the magic?
+Graph *bingraph_load(const char *filename, int verify);	// map a file, verify checks the checksum
+int    bingraph_save(Graph *g, const char *filename);	// write a frozen graph, 1 on success
+uint64_t bingraph_checksum(const void *data, size_t n);
+uint64_t bingraph_checksum_update(uint64_t h, const void *data, size_t n);
+bingraph_writer_t *bingraph_writer_open(const char *filename, int H, int S, int64_t num_edges);
+int    bingraph_writer_put(bingraph_writer_t *w, const void *data, size_t n);
+int    bingraph_writer_close(bingraph_writer_t *w);	// 1 if the whole file was written
@@ -0,0 +1,166 @@
+/*
+** Bitset Module
+** |a & b| is a streaming popcount over the two word arrays. The kernel is
+** picked once from what the CPU supports: AVX-512 VPOPCNTDQ, AVX2 (the
+** nibble lookup popcount with pshufb), or the scalar popcount builtin.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include "bitset.h"
+
+/*
+** Create an empty set over [0, nbits)
+*/
+bitset_t
+*bitset_new(int nbits) {
+    assert(nbits >= 0);
+    bitset_t *b = (bitset_t *)malloc(sizeof(*b));
+    assert(b);
+    b->nbits = nbits;
+    b->nwords = ((nbits + 63) / 64 + BITSET_BLOCK_WORDS - 1)
+              / BITSET_BLOCK_WORDS * BITSET_BLOCK_WORDS;
+    if (b->nwords == 0) {
+        b->nwords = BITSET_BLOCK_WORDS;
+    }
+    b->words = (uint64_t *)aligned_alloc(64, sizeof(uint64_t) * b->nwords);
+    assert(b->words);
+    memset(b->words, 0, sizeof(uint64_t) * b->nwords);
+    return b;
+}
+
+/*
+** Free the memory allocated to the set
+*/
+void
+bitset_free(bitset_t *b) {
+    assert(b);
+    free(b->words);
+    free(b);
+}
+
+/*
+** Add every element of [0, nbits), leaving the padding bits clear
+*/
+void
+bitset_fill(bitset_t *b) {
+    int full = b->nbits / 64;
+    memset(b->words, 0xff, sizeof(uint64_t) * full);
+    if (b->nbits % 64) {
+        b->words[full] = ((uint64_t)1 << (b->nbits % 64)) - 1;
+    }
+}
+
+/*
+** a &= ~b, the words are independent so the compiler vectorises this
+*/
+void
+bitset_andnot(bitset_t *a, const bitset_t *b) {
+    assert(a->nwords == b->nwords);
+    uint64_t *__restrict x = a->words;
+    const uint64_t *__restrict y = b->words;
+    for (int i = 0; i < a->nwords; i++) {
+        x[i] &= ~y[i];
+    }
+}
+
+static int
+count_and_scalar(const uint64_t *a, const uint64_t *b, int nwords) {
+    int n = 0;
+    for (int i = 0; i < nwords; i++) {
+        n += __builtin_popcountll(a[i] & b[i]);
+    }
+    return n;
+}
+
+__attribute__((target("avx2")))
+static int
+count_and_avx2(const uint64_t *a, const uint64_t *b, int nwords) {
+    // popcount of each nibble, looked up 32 bytes at a time
+    const __m256i lut = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                         0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < nwords; i += 4) {
+        __m256i v = _mm256_and_si256(_mm256_load_si256((const __m256i *)(a + i)),
+                                     _mm256_load_si256((const __m256i *)(b + i)));
+        __m256i c = _mm256_add_epi8(
+            _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+            _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+        // sum the byte counts into the four 64-bit lanes
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(c, _mm256_setzero_si256()));
+    }
+    uint64_t lane[4];
+    _mm256_storeu_si256((__m256i *)lane, acc);
+    return (int)(lane[0] + lane[1] + lane[2] + lane[3]);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static int
+count_and_avx512(const uint64_t *a, const uint64_t *b, int nwords) {
+    __m512i acc = _mm512_setzero_si512();
+    for (int i = 0; i < nwords; i += 8) {
+        __m512i v = _mm512_and_si512(_mm512_load_si512(a + i), _mm512_load_si512(b + i));
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+    }
+    uint64_t lane[8];
+    _mm512_storeu_si512(lane, acc);
+    return (int)(lane[0] + lane[1] + lane[2] + lane[3]
+               + lane[4] + lane[5] + lane[6] + lane[7]);
+}
+
+typedef int (*count_and_fn)(const uint64_t *, const uint64_t *, int);
+
+// set once by choose_kernel, under kernel_once since pool workers may
+// be the first to count
+static count_and_fn count_and = count_and_scalar;
+static const char *kernel_name = "scalar";
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+
+/*
+** Pick the fastest kernel this CPU can run
+*/
+static void
+choose_kernel(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512vpopcntdq")) {
+        kernel_name = "avx512";
+        count_and = count_and_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        kernel_name = "avx2";
+        count_and = count_and_avx2;
+    } else {
+        kernel_name = "scalar";
+        count_and = count_and_scalar;
+    }
+}
+
+/*
+** |a & b|
+*/
+int
+bitset_count_and(const bitset_t *a, const bitset_t *b) {
+    assert(a->nwords == b->nwords);
+    pthread_once(&kernel_once, choose_kernel);
+    return count_and(a->words, b->words, a->nwords);
+}
+
+/*
+** |b|
+*/
+int
+bitset_count(const bitset_t *b) {
+    return bitset_count_and(b, b);
+}
+
+/*
+** Name of the kernel bitset_count_and uses
+*/
+const char
+*bitset_kernel(void) {
+    pthread_once(&kernel_once, choose_kernel);
+    return kernel_name;
+}
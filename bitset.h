@@ -0,0 +1,38 @@
+/*
+** Bitset Module - header file
+** Dense sets of small integers [0, nbits) stored one bit each in 64-bit
+** words. The word array is cache line aligned and padded to a whole
+** number of 512-bit blocks (kept zero) so the SIMD kernels need no tail.
+*/
+#include <stdint.h>
+
+typedef struct {
+    int       nbits;	// elements are 0..nbits-1
+    int       nwords;	// words allocated, a multiple of BITSET_BLOCK_WORDS
+    uint64_t *words;	// bit i is (words[i/64] >> (i%64)) & 1
+} bitset_t;
+
+#define BITSET_BLOCK_WORDS 8
+
+bitset_t *bitset_new(int nbits);	// empty set over [0, nbits)
+void bitset_free(bitset_t *b);
+void bitset_fill(bitset_t *b);		// every element present
+int  bitset_count(const bitset_t *b);	// |b|
+int  bitset_count_and(const bitset_t *a, const bitset_t *b);	// |a & b|
+void bitset_andnot(bitset_t *a, const bitset_t *b);		// a &= ~b
+const char *bitset_kernel(void);	// name of the popcount kernel in use
+
+static inline void
+bitset_add(bitset_t *b, int i) {
+    b->words[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static inline void
+bitset_remove(bitset_t *b, int i) {
+    b->words[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+static inline int
+bitset_has(const bitset_t *b, int i) {
+    return (int)((b->words[i >> 6] >> (i & 63)) & 1);
+}
@@ -0,0 +1,231 @@
+/*
+** cbench
+** Compares the forms the coverage of every school can be kept in: the
+** linked lists the searches return, sorted int arrays of the houses, and
+** the packed sets of cset.h. Reports the bytes per covered house of each
+** and the time to intersect every school with the uncovered houses, as
+** a bitset (the greedy's gain) and as a sorted list (merging for the
+** arrays, galloping for the packed sets), as JSON, single threaded.
+**
+**   cbench [-n repeats] [-r radius] [-u percent] graph ...
+*/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "input.h"
+#include "bingraph.h"
+#include "bitset.h"
+#include "cset.h"
+#include "solver.h"
+#include "stats.h"
+
+static int
+cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+** |a & b| of two sorted arrays by merging
+*/
+static int
+count_merge(const int *a, int na, const int *b, int nb) {
+    int i = 0, j = 0, count = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (a[i] > b[j]) {
+            j++;
+        } else {
+            count++;
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+// the forms of one instance's coverage
+typedef struct {
+    int S;
+    set_t **lists;		// as the searches return them, every vertex reached
+    int **raw;			// the houses of each, sorted
+    int *n;
+    cset_t **packed;
+    bitset_t *U;		// the uncovered houses
+    int *V, nV;			// and as a sorted list
+} forms_t;
+
+/*
+** Time each way of computing sum |S & U| over every school, best of
+** repeats, in ns per covered house; all ways must agree
+*/
+static int
+time_ways(forms_t *f, int repeats, long pairs, double *ns) {
+    long sum[5] = {0, 0, 0, 0, 0};
+    for (int w = 0; w < 5; w++) {
+        ns[w] = -1;
+        for (int r = 0; r < repeats; r++) {
+            long total = 0;
+            double t = stats_now();
+            for (int s = 0; s < f->S; s++) {
+                switch (w) {
+                case 0:
+                    for (node_t *p = f->lists[s]->head; p != NULL; p = p->next) {
+                        total += (int)p->data < f->U->nbits && bitset_has(f->U, p->data);
+                    }
+                    break;
+                case 1:
+                    for (int k = 0; k < f->n[s]; k++) {
+                        total += bitset_has(f->U, f->raw[s][k]);
+                    }
+                    break;
+                case 2:
+                    total += cset_count_bitset(f->packed[s], f->U);
+                    break;
+                case 3:
+                    total += count_merge(f->raw[s], f->n[s], f->V, f->nV);
+                    break;
+                case 4:
+                    total += cset_count_sorted(f->packed[s], f->V, f->nV);
+                    break;
+                }
+            }
+            t = (stats_now() - t) * 1e9 / (pairs > 0 ? pairs : 1);
+            if (ns[w] < 0 || t < ns[w]) {
+                ns[w] = t;
+            }
+            sum[w] = total;
+        }
+    }
+    for (int w = 1; w < 5; w++) {
+        if (sum[w] != sum[0]) {
+            fprintf(stderr, "ERROR! intersection %d gives %ld, not %ld\n", w, sum[w], sum[0]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+** Build every form for filename and time them, one line of JSON to out.
+** return 1 if that went well
+*/
+static int
+bench(const char *filename, int repeats, Distance radius, int percent, FILE *out) {
+    Graph *g = bingraph_is_file(filename) ? bingraph_load(filename, 0)
+                                          : input_graph_file(filename);
+    if (g == NULL) {
+        return 0;
+    }
+    forms_t f;
+    f.S = g->S;
+    f.lists = (set_t **)malloc(sizeof(set_t *) * (g->S + 1));
+    f.raw = (int **)malloc(sizeof(int *) * (g->S + 1));
+    f.n = (int *)malloc(sizeof(int) * (g->S + 1));
+    f.packed = (cset_t **)malloc(sizeof(cset_t *) * (g->S + 1));
+    assert(f.lists && f.raw && f.n && f.packed);
+    compute_coverage(g, f.lists, NULL, radius, choose_queue(g, radius, QUEUE_AUTO), 1);
+
+    long pairs = 0, reached = 0;
+    size_t list_bytes = 0, raw_bytes = 0, packed_bytes = 0;
+    for (int s = 0; s < g->S; s++) {
+        f.raw[s] = (int *)malloc(sizeof(int) * (f.lists[s]->n + 1));
+        assert(f.raw[s]);
+        int n = 0;
+        for (node_t *p = f.lists[s]->head; p != NULL; p = p->next) {
+            if ((int)p->data < g->H) {
+                f.raw[s][n++] = p->data;
+            }
+        }
+        qsort(f.raw[s], n, sizeof(int), cmp_int);
+        f.n[s] = n;
+        f.packed[s] = cset_new(f.raw[s], n);
+        pairs += n;
+        reached += f.lists[s]->n;
+        list_bytes += sizeof(set_t) + sizeof(node_t) * f.lists[s]->n;
+        raw_bytes += sizeof(int) * n;
+        packed_bytes += cset_bytes(f.packed[s]);
+    }
+
+    // a fixed pseudo random percent of the houses are left uncovered
+    f.U = bitset_new(g->H);
+    f.V = (int *)malloc(sizeof(int) * (g->H + 1));
+    assert(f.V);
+    f.nV = 0;
+    unsigned int x = 12345;
+    for (int h = 0; h < g->H; h++) {
+        x = x * 1103515245u + 12345u;
+        if ((int)((x >> 16) % 100) < percent) {
+            bitset_add(f.U, h);
+            f.V[f.nV++] = h;
+        }
+    }
+
+    double ns[5];
+    int ok = time_ways(&f, repeats, pairs, ns);
+    fprintf(out, "{\"name\": \"%s\", \"schools\": %d, \"houses\": %d, \"covered_pairs\": %ld, "
+            "\"reached_pairs\": %ld, \"uncovered_percent\": %d, "
+            "\"bytes_per_pair\": {\"list\": %.2f, \"array\": %.2f, \"packed\": %.2f}, "
+            "\"ns_per_pair\": {\"list_bitset\": %.3f, \"array_bitset\": %.3f, "
+            "\"packed_bitset\": %.3f, \"array_merge\": %.3f, \"packed_gallop\": %.3f}}",
+            filename, g->S, g->H, pairs, reached, percent,
+            pairs ? (double)list_bytes / pairs : 0, pairs ? (double)raw_bytes / pairs : 0,
+            pairs ? (double)packed_bytes / pairs : 0, ns[0], ns[1], ns[2], ns[3], ns[4]);
+
+    for (int s = 0; s < g->S; s++) {
+        free_set(f.lists[s]);
+        free(f.raw[s]);
+        cset_free(f.packed[s]);
+    }
+    free(f.lists);
+    free(f.raw);
+    free(f.n);
+    free(f.packed);
+    free(f.V);
+    bitset_free(f.U);
+    free_graph(g);
+    return ok;
+}
+
+int
+main(int argc, char *argv[]) {
+    int opt, repeats = 5, percent = 50;
+    Distance radius = COVER_RADIUS;
+    while ((opt = getopt(argc, argv, "n:r:u:")) != -1) {
+        switch (opt) {
+        case 'n':
+            repeats = atoi(optarg) > 0 ? atoi(optarg) : 1;
+            break;
+        case 'r':
+            radius = (Distance)atof(optarg);
+            break;
+        case 'u':
+            percent = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n repeats] [-r radius] [-u percent] graph ...\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-n repeats] [-r radius] [-u percent] graph ...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    printf("{\n\"repeats\": %d, \"radius\": %g, \"pointer_bytes\": %d, \"block\": %d,\n"
+           "\"instances\": [\n", repeats, radius, (int)sizeof(void *), CSET_BLOCK);
+    for (int a = optind; a < argc; a++) {
+        if (!bench(argv[a], repeats, radius, percent, stdout)) {
+            return EXIT_FAILURE;
+        }
+        printf("%s\n", a + 1 < argc ? "," : "");
+    }
+    printf("]\n}\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,501 @@
+/*
+** Coverage Module
+** The greedy set cover on bitsets: the uncovered houses U are a bitset,
+** so the gain of a dense school is a popcount of its words ANDed with
+** U's, and the gain of a sparse one is a lookup of each of its houses
+** as they are decoded.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "bitset.h"
+#include "cset.h"
+#include "cover.h"
+#include "stats.h"
+
+static int
+cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+** Build the coverage of school from the set of vertices its search
+** reached, keeping only the houses (labels below H)
+*/
+cover_t
+*cover_from_set(set_t *s, Label school, int H) {
+    return cover_from_prefix(s, s->n, school, H);
+}
+
+/*
+** As cover_from_set, from only the first count elements of s (the
+** vertices within a smaller radius, as the search adds them in order
+** of distance)
+*/
+cover_t
+*cover_from_prefix(set_t *s, int count, Label school, int H) {
+    assert(s && count <= s->n);
+    int *houses = (int *)malloc(sizeof(int) * (count + 1));
+    assert(houses);
+    int n = 0;
+    node_t *p = s->head;
+    for (int k = 0; k < count; k++, p = p->next) {
+        if ((int)p->data < H) {
+            houses[n++] = p->data;
+        }
+    }
+    qsort(houses, n, sizeof(int), cmp_int);
+    cover_t *c = cover_from_houses(houses, n, school, H);
+    free(houses);
+    return c;
+}
+
+/*
+** Build the coverage of school from the sorted house labels houses[0..n-1]
+*/
+cover_t
+*cover_from_houses(const int *houses, int n, Label school, int H) {
+    cover_t *c = (cover_t *)malloc(sizeof(*c));
+    assert(c);
+    c->school = school;
+    c->n = n;
+    if ((long)n * COVER_DENSE_DIVISOR >= H && H > 0) {
+        c->bits = bitset_new(H);
+        for (int i = 0; i < n; i++) {
+            bitset_add(c->bits, houses[i]);
+        }
+        c->packed = NULL;
+    } else {
+        c->packed = cset_new(houses, n);
+        c->bits = NULL;
+    }
+    return c;
+}
+
+/*
+** Free the memory allocated to the coverage
+*/
+void
+cover_free(cover_t *c) {
+    assert(c);
+    if (c->bits) {
+        bitset_free(c->bits);
+    }
+    if (c->packed) {
+        cset_free(c->packed);
+    }
+    free(c);
+}
+
+/*
+** The bytes c takes, not counting malloc's overhead
+*/
+size_t
+cover_bytes(const cover_t *c) {
+    if (c->bits) {
+        return sizeof(*c) + sizeof(bitset_t) + sizeof(uint64_t) * c->bits->nwords;
+    }
+    return sizeof(*c) + cset_bytes(c->packed);
+}
+
+/*
+** The number of houses in c that are still in U
+*/
+int
+cover_count_uncovered(const cover_t *c, const bitset_t *U) {
+    if (c->bits) {
+        return bitset_count_and(c->bits, U);
+    }
+    return cset_count_bitset(c->packed, U);
+}
+
+/*
+** Remove the houses in c from U
+*/
+void
+cover_remove(const cover_t *c, bitset_t *U) {
+    if (c->bits) {
+        bitset_andnot(U, c->bits);
+        return;
+    }
+    cset_remove_bitset(c->packed, U);
+}
+
+/*
+** Write the houses of c to houses[0..c->n-1] in ascending order
+*/
+int
+cover_houses(const cover_t *c, int *houses) {
+    if (c->packed) {
+        return cset_decode(c->packed, houses);
+    }
+    int n = 0;
+    for (int w = 0; w < c->bits->nwords; w++) {
+        uint64_t word = c->bits->words[w];
+        while (word) {
+            houses[n++] = w * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+        }
+    }
+    return n;
+}
+
+/*
+** The eager greedy's scan for the school of largest gain, split over
+** threads when there is enough to scan. Each worker finds the lowest
+** indexed best of its contiguous share and the shares are reduced in
+** order, so the answer is the one the scan on a single thread gives.
+*/
+typedef struct {
+    int gain, index;
+    char pad[56];		// keep each worker's best on its own cache line
+} scan_best_t;
+
+struct scan;
+
+typedef struct {
+    struct scan *scan;
+    int worker;
+} scan_arg_t;
+
+typedef struct scan {
+    cover_t **covers;
+    int nset;
+    const bitset_t *U;		// read by every worker, changed between rounds only
+    int nworkers;		// shares of the schools, 1 to scan on the caller alone
+    int started;		// workers 1..started-1 run on their own threads
+    int *bound;			// worker w scans [bound[w], bound[w+1])
+    scan_best_t *best;
+    scan_arg_t *arg;
+    pthread_t *tid;
+    pthread_mutex_t lock;
+    pthread_cond_t go, finished;
+    int round, pending, quit;
+} scan_t;
+
+/*
+** The lowest index in [lo, hi) with the largest gain over U, into best
+*/
+static void
+scan_range(cover_t **covers, int lo, int hi, const bitset_t *U, scan_best_t *best) {
+    int max = 0, index = 0;
+    for (int i = lo; i < hi; i++) {
+        int gain = cover_count_uncovered(covers[i], U);
+        if (gain > max) {
+            max = gain;
+            index = i;
+        }
+    }
+    best->gain = max;
+    best->index = index;
+}
+
+/*
+** A worker thread: wait for each round, scan its share and report
+** back, until told to quit
+*/
+static void
+*scan_worker(void *data) {
+    scan_arg_t *a = (scan_arg_t *)data;
+    scan_t *sc = a->scan;
+    int seen = 0, quit;
+    for (;;) {
+        pthread_mutex_lock(&sc->lock);
+        while (sc->round == seen && !sc->quit) {
+            pthread_cond_wait(&sc->go, &sc->lock);
+        }
+        seen = sc->round;
+        quit = sc->quit;
+        pthread_mutex_unlock(&sc->lock);
+        if (quit) {
+            return NULL;
+        }
+        scan_range(sc->covers, sc->bound[a->worker], sc->bound[a->worker + 1], sc->U,
+                   &sc->best[a->worker]);
+        pthread_mutex_lock(&sc->lock);
+        if (--sc->pending == 0) {
+            pthread_cond_signal(&sc->finished);
+        }
+        pthread_mutex_unlock(&sc->lock);
+    }
+}
+
+/*
+** Get a scan of covers over U ready, on up to nworkers threads if the
+** work of a round is worth it, each share being about the same work
+*/
+static void
+scan_start(scan_t *sc, cover_t **covers, int nset, const bitset_t *U, int nworkers) {
+    int i, w;
+    long work = 0, sum = 0;
+    for (i = 0; i < nset; i++) {
+        work += covers[i]->bits ? covers[i]->bits->nwords : covers[i]->n;
+    }
+    sc->covers = covers;
+    sc->nset = nset;
+    sc->U = U;
+    sc->nworkers = sc->started = 1;
+    if (nworkers > nset) {
+        nworkers = nset;
+    }
+    if (nworkers <= 1 || work < COVER_PARALLEL_MIN_WORK) {
+        return;
+    }
+
+    sc->nworkers = nworkers;
+    sc->bound = (int *)malloc(sizeof(int) * (nworkers + 1));
+    sc->best = (scan_best_t *)malloc(sizeof(scan_best_t) * nworkers);
+    sc->arg = (scan_arg_t *)malloc(sizeof(scan_arg_t) * nworkers);
+    sc->tid = (pthread_t *)malloc(sizeof(pthread_t) * nworkers);
+    assert(sc->bound && sc->best && sc->arg && sc->tid);
+    // cut where the running work passes each worker's share of it
+    sc->bound[0] = 0;
+    for (i = 0, w = 1; i < nset && w < nworkers; i++) {
+        sum += covers[i]->bits ? covers[i]->bits->nwords : covers[i]->n;
+        while (w < nworkers && sum * nworkers >= work * w) {
+            sc->bound[w++] = i + 1;
+        }
+    }
+    while (w <= nworkers) {
+        sc->bound[w++] = nset;
+    }
+
+    pthread_mutex_init(&sc->lock, NULL);
+    pthread_cond_init(&sc->go, NULL);
+    pthread_cond_init(&sc->finished, NULL);
+    sc->round = sc->pending = sc->quit = 0;
+    for (w = 1; w < nworkers; w++) {
+        sc->arg[w].scan = sc;
+        sc->arg[w].worker = w;
+        // if a thread cannot be started the caller scans the shares left
+        if (pthread_create(&sc->tid[w], NULL, scan_worker, &sc->arg[w]) != 0) {
+            break;
+        }
+        sc->started = w + 1;
+    }
+}
+
+/*
+** Find the lowest index of largest gain over U as it is now.
+** return the gain, index is set to the school (0 if the gain is 0)
+*/
+static int
+scan_round(scan_t *sc, int *index) {
+    if (sc->nworkers == 1) {
+        scan_best_t best;
+        scan_range(sc->covers, 0, sc->nset, sc->U, &best);
+        *index = best.index;
+        return best.gain;
+    }
+    pthread_mutex_lock(&sc->lock);
+    sc->pending = sc->started - 1;
+    sc->round++;
+    pthread_cond_broadcast(&sc->go);
+    pthread_mutex_unlock(&sc->lock);
+
+    scan_range(sc->covers, sc->bound[0], sc->bound[1], sc->U, &sc->best[0]);
+    for (int w = sc->started; w < sc->nworkers; w++) {
+        scan_range(sc->covers, sc->bound[w], sc->bound[w + 1], sc->U, &sc->best[w]);
+    }
+    pthread_mutex_lock(&sc->lock);
+    while (sc->pending > 0) {
+        pthread_cond_wait(&sc->finished, &sc->lock);
+    }
+    pthread_mutex_unlock(&sc->lock);
+
+    // the shares are in index order, a later one must do strictly better
+    int max = 0;
+    *index = 0;
+    for (int w = 0; w < sc->nworkers; w++) {
+        if (sc->best[w].gain > max) {
+            max = sc->best[w].gain;
+            *index = sc->best[w].index;
+        }
+    }
+    return max;
+}
+
+static void
+scan_stop(scan_t *sc) {
+    if (sc->nworkers == 1) {
+        return;
+    }
+    pthread_mutex_lock(&sc->lock);
+    sc->quit = 1;
+    pthread_cond_broadcast(&sc->go);
+    pthread_mutex_unlock(&sc->lock);
+    for (int w = 1; w < sc->started; w++) {
+        pthread_join(sc->tid[w], NULL);
+    }
+    pthread_cond_destroy(&sc->go);
+    pthread_cond_destroy(&sc->finished);
+    pthread_mutex_destroy(&sc->lock);
+    free(sc->bound);
+    free(sc->best);
+    free(sc->arg);
+    free(sc->tid);
+}
+
+/*
+** Greedy set cover over the coverage sets, giving exactly the answer of
+** set_cover() on the equivalent lists: each round takes the lowest
+** indexed school with the largest number of uncovered houses, and it
+** stops when the rest cannot be covered, leaving st->uncovered houses;
+** set_cover ends on index 0 then, which solve_covers adds. Each round's scan
+** runs over nworkers threads when there is enough to scan, see scan_start.
+** return an array of the chosen school vertices, num is set to its size
+*/
+int
+*cover_greedy(cover_t **covers, int nset, int H, int nworkers, int *num,
+              greedy_stats_t *st) {
+    int *A = (int *)malloc(sizeof(*A) * (nset + 1));
+    assert(A);
+    int A_n = 0, count = 0, remaining = H;
+
+    bitset_t *U = bitset_new(H);
+    bitset_fill(U);
+    scan_t sc;
+    scan_start(&sc, covers, nset, U, nworkers);
+    while (remaining > 0 && count < nset) {
+        //select S with max S intersect U
+        int index, max = scan_round(&sc, &index);
+        if (max == 0) {
+            // nothing left can be covered, see solve_covers
+            break;
+        }
+        // the workers are waiting for the next round, U is ours to change
+        cover_remove(covers[index], U);
+        remaining -= max;
+        // a school with gain left has not been chosen before
+        A[A_n++] = covers[index]->school;
+        count++;
+    }
+    // the last round finds no gain unless U or the schools ran out
+    long rounds = count + (remaining > 0 && count < nset);
+    STAT_ADD(STAT_ROUNDS, rounds);
+    STAT_ADD(STAT_INTERSECTIONS, rounds * nset);
+    if (st) {
+        st->rounds = A_n;
+        st->evaluations = rounds * nset;
+        st->saved = 0;
+        st->updates = 0;
+        st->workers = sc.started;
+        st->uncovered = remaining;
+    }
+    scan_stop(&sc);
+    bitset_free(U);
+    *num = A_n;
+    return A;
+}
+
+/*
+** A candidate in the lazy greedy queue, gain is an upper bound on its
+** current gain since gains only shrink as U does
+*/
+typedef struct {
+    int gain;
+    int index;
+    int round;	// the round gain was computed in, it is exact in that round
+} candidate_t;
+
+/*
+** Queue order: larger gain first, then lower index, as the eager scan
+*/
+static inline int
+before(candidate_t a, candidate_t b) {
+    return a.gain > b.gain || (a.gain == b.gain && a.index < b.index);
+}
+
+static void
+cand_sift_down(candidate_t *q, int n, int root) {
+    candidate_t t = q[root];
+    int child;
+    while ((child = 2*root+1) < n) {
+        if (child + 1 < n && before(q[child+1], q[child])) {
+            child++;
+        }
+        if (!before(q[child], t)) {
+            break;
+        }
+        q[root] = q[child];
+        root = child;
+    }
+    q[root] = t;
+}
+
+/*
+** Lazy (CELF style) greedy set cover, same answer as cover_greedy().
+** Candidates sit in a max queue on possibly stale gains. Only the top
+** one is re-evaluated; it is chosen if its fresh gain still comes
+** before every stale gain left, otherwise it goes back in with the fresh
+** gain. As a stale gain never understates a fresh one, the chosen school
+** is the one the eager scan would choose, ties included.
+*/
+int
+*cover_greedy_lazy(cover_t **covers, int nset, int H, int *num, greedy_stats_t *st) {
+    int *A = (int *)malloc(sizeof(*A) * (nset + 1));
+    candidate_t *q = (candidate_t *)malloc(sizeof(*q) * (nset + 1));
+    assert(A && q);
+    int A_n = 0, count = 0, remaining = H, n = 0, i;
+    long evaluations = 0;
+
+    // with U full every gain is the size of the set, no need to count
+    for (i=0;i<nset;i++) {
+        q[n].gain = covers[i]->n;
+        q[n].index = i;
+        q[n].round = 0;
+        n++;
+    }
+    for (i=n/2-1;i>=0;i--) {
+        cand_sift_down(q, n, i);
+    }
+
+    bitset_t *U = bitset_new(H);
+    bitset_fill(U);
+    while (remaining > 0 && count < nset && n > 0) {
+        candidate_t top = q[0];
+        if (top.round != count) {
+            top.gain = cover_count_uncovered(covers[top.index], U);
+            top.round = count;
+            evaluations++;
+        }
+        if (n > 1 && !before(top, q[1 + (n > 2 && before(q[2], q[1]))])) {
+            // another candidate may do better, requeue with the fresh gain
+            q[0] = top;
+            cand_sift_down(q, n, 0);
+            continue;
+        }
+        if (top.gain == 0) {
+            // nothing left can be covered, see solve_covers
+            count++;
+            break;
+        }
+        q[0] = q[--n];
+        cand_sift_down(q, n, 0);
+        cover_remove(covers[top.index], U);
+        remaining -= top.gain;
+        A[A_n++] = covers[top.index]->school;
+        count++;
+    }
+    STAT_ADD(STAT_ROUNDS, count);
+    STAT_ADD(STAT_INTERSECTIONS, evaluations);
+    if (st) {
+        st->rounds = A_n;
+        st->evaluations = evaluations;
+        st->saved = (long)count * nset - evaluations;
+        st->updates = 0;
+        st->workers = 1;
+        st->uncovered = remaining;
+    }
+    bitset_free(U);
+    free(q);
+    *num = A_n;
+    return A;
+}
@@ -0,0 +1,44 @@
+/*
+** Coverage Module - header file
+** The houses a school covers, kept in one of two forms chosen by how
+** many of the H houses it covers: a bitset over [0, H) for dense sets,
+** or the house labels packed as a compressed set (see cset.h) for
+** sparse ones.
+*/
+
+// a set covering at least H/COVER_DENSE_DIVISOR houses is stored as a
+// bitset, whose popcounts are faster than decoding the packed houses
+#define COVER_DENSE_DIVISOR 32
+
+// below this many words and houses to look at a round, the eager greedy
+// scans on one thread, as waking the others would cost more than it saves
+#define COVER_PARALLEL_MIN_WORK 16384
+
+typedef struct cover {
+    Label     school;	// the school vertex whose coverage this is
+    int       n;	// number of houses covered
+    struct cset *packed;	// the house labels if sparse, else NULL
+    bitset_t *bits;	// bitset over [0, H) if dense, else NULL
+} cover_t;
+
+// counters filled in by the greedy functions
+typedef struct {
+    long rounds;	// schools chosen
+    long evaluations;	// |S & U| computations done
+    long saved;		// evaluations an eager scan of every round would add
+    long updates;	// single house gain decrements (bucket greedy)
+    int  workers;	// threads each round's scan ran over
+    int  uncovered;	// houses left that no candidate covers
+} greedy_stats_t;
+
+cover_t *cover_from_set(set_t *s, Label school, int H);
+cover_t *cover_from_prefix(set_t *s, int count, Label school, int H);	// first count elements only
+cover_t *cover_from_houses(const int *houses, int n, Label school, int H);	// houses sorted
+void cover_free(cover_t *c);
+size_t cover_bytes(const cover_t *c);			// memory c takes
+int  cover_count_uncovered(const cover_t *c, const bitset_t *U);	// |c & U|
+void cover_remove(const cover_t *c, bitset_t *U);		// U = U - c
+int  cover_houses(const cover_t *c, int *houses);	// list c in ascending order, returns c->n
+int *cover_greedy(cover_t **covers, int nset, int H, int nworkers, int *num,
+                  greedy_stats_t *st);
+int *cover_greedy_lazy(cover_t **covers, int nset, int H, int *num, greedy_stats_t *st);
@@ -0,0 +1,112 @@
+/*
+** coververify
+** Checks a solution printed by assn2 against the graph, replacing the
+** old Windows-only verify.exe: every chosen school's search is run again
+** and any house none of them reaches within the radius is reported.
+** A sweep's "radius r" lines start a block checked at that radius.
+**
+**   assn2 graph | coververify [-t threads] [-r radius] [-c] graph
+**   coververify [-t threads] [-r radius] [-c] graph solution
+**
+** Exits 0 if every block covers every house, 1 otherwise.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "pool.h"
+#include "input.h"
+#include "bingraph.h"
+#include "verify.h"
+#include "stats.h"
+
+/*
+** Check one block of school indices; return 1 if it covers every house
+*/
+static int
+check_block(Graph *g, Label *schools, int n, Distance radius, int nworkers) {
+    verify_result_t res;
+    double t = stats_now();
+    int ok = verify_cover(g, schools, n, radius, nworkers, &res);
+    t = (stats_now() - t) * 1e3;
+    printf("radius %g: ", radius);
+    verify_report(&res, stdout);
+    printf("verified in %.3f ms\n", t);
+    verify_result_free(&res);
+    return ok;
+}
+
+int
+main(int argc, char *argv[]) {
+    int opt, nworkers = pool_default_workers(), checksum = 0;
+    Distance radius = COVER_RADIUS;
+    while ((opt = getopt(argc, argv, "t:r:c")) != -1) {
+        switch (opt) {
+        case 't':
+            nworkers = atoi(optarg) > 0 ? atoi(optarg) : 1;
+            break;
+        case 'r':
+            radius = (Distance)atof(optarg);
+            break;
+        case 'c':
+            checksum = 1;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t threads] [-r radius] [-c] graph [solution]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc || optind + 2 < argc) {
+        fprintf(stderr, "usage: %s [-t threads] [-r radius] [-c] graph [solution]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    FILE *fp = optind + 1 < argc ? fopen(argv[optind + 1], "r") : stdin;
+    if (fp == NULL) {
+        perror(argv[optind + 1]);
+        return EXIT_FAILURE;
+    }
+    Graph *g = bingraph_is_file(argv[optind]) ? bingraph_load(argv[optind], checksum)
+                                              : input_graph_file(argv[optind]);
+    if (g == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    // the solution lists schools by index, 0 for vertex H
+    int n = 0, size = 64, ok = 1, blocks = 0;
+    Label *schools = (Label *)malloc(sizeof(Label) * size);
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        double r;
+        char *end;
+        if (sscanf(line, "radius %lf", &r) == 1) {
+            if (blocks++ > 0 || n > 0) {
+                ok &= check_block(g, schools, n, radius, nworkers);
+            }
+            radius = (Distance)r;
+            n = 0;
+            continue;
+        }
+        long idx = strtol(line, &end, 10);
+        if (end == line) {
+            continue;
+        }
+        if (n == size) {
+            size *= 2;
+            schools = (Label *)realloc(schools, sizeof(Label) * size);
+        }
+        // anything out of range is passed on as it is, and reported
+        schools[n++] = idx < 0 || idx >= g->S ? -1 : (Label)(g->H + idx);
+    }
+    ok &= check_block(g, schools, n, radius, nworkers);
+
+    if (fp != stdin) {
+        fclose(fp);
+    }
+    free(schools);
+    free_graph(g);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
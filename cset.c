@@ -0,0 +1,332 @@
+/*
+** Compressed Set Module
+** The header, the block index and the gap bytes share one allocation,
+** so a set of n houses within a few hundred of each other takes about
+** n bytes plus a handful, against 4n for an int array and 16n or more
+** for a linked list on a 64-bit build.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitset.h"
+#include "cset.h"
+
+static inline int
+nblocks_of(const cset_t *c) {
+    return (c->n + CSET_BLOCK - 1) / CSET_BLOCK;
+}
+
+static inline const int
+*first_of(const cset_t *c) {
+    return (const int *)(c + 1);
+}
+
+static inline const uint32_t
+*offset_of(const cset_t *c) {
+    return (const uint32_t *)(first_of(c) + nblocks_of(c));
+}
+
+static inline const uint8_t
+*bytes_of(const cset_t *c) {
+    return (const uint8_t *)(offset_of(c) + nblocks_of(c));
+}
+
+/*
+** Number of bytes the varint for x takes
+*/
+static inline int
+varint_size(uint32_t x) {
+    int k = 1;
+    while (x >= 128) {
+        x >>= 7;
+        k++;
+    }
+    return k;
+}
+
+static inline uint8_t
+*varint_put(uint8_t *p, uint32_t x) {
+    while (x >= 128) {
+        *p++ = (uint8_t)(x | 128);
+        x >>= 7;
+    }
+    *p++ = (uint8_t)x;
+    return p;
+}
+
+static inline uint32_t
+varint_get(const uint8_t **pp) {
+    const uint8_t *p = *pp;
+    uint32_t x = *p++;
+    if (x >= 128) {
+        // a gap of 128 or more, rare in a dense coverage set
+        int shift = 7;
+        x &= 127;
+        uint32_t b;
+        do {
+            b = *p++;
+            x |= (b & 127) << shift;
+            shift += 7;
+        } while (b >= 128);
+    }
+    *pp = p;
+    return x;
+}
+
+/*
+** Pack v[0..n-1], which must be strictly increasing and non-negative
+*/
+cset_t
+*cset_new(const int *v, int n) {
+    int i, nblocks = (n + CSET_BLOCK - 1) / CSET_BLOCK;
+    size_t nbytes = 0;
+    for (i = 1; i < n; i++) {
+        assert(v[i] > v[i-1]);
+        if (i % CSET_BLOCK != 0) {
+            nbytes += varint_size((uint32_t)(v[i] - v[i-1]));
+        }
+    }
+    // header, then first[], offset[] and the bytes, each suitably aligned
+    size_t size = sizeof(cset_t) + (sizeof(int) + sizeof(uint32_t)) * nblocks + nbytes;
+    cset_t *c = (cset_t *)malloc(size);
+    assert(c);
+    c->n = n;
+    c->nbytes = (int)nbytes;
+    int *first = (int *)first_of(c);
+    uint32_t *offset = (uint32_t *)offset_of(c);
+    uint8_t *bytes = (uint8_t *)bytes_of(c), *p = bytes;
+    for (i = 0; i < n; i++) {
+        if (i % CSET_BLOCK == 0) {
+            first[i / CSET_BLOCK] = v[i];
+            offset[i / CSET_BLOCK] = (uint32_t)(p - bytes);
+        } else {
+            p = varint_put(p, (uint32_t)(v[i] - v[i-1]));
+        }
+    }
+    assert((size_t)(p - bytes) == nbytes);
+    return c;
+}
+
+void
+cset_free(cset_t *c) {
+    free(c);
+}
+
+size_t
+cset_bytes(const cset_t *c) {
+    return sizeof(cset_t) + (sizeof(int) + sizeof(uint32_t)) * nblocks_of(c) + c->nbytes;
+}
+
+/*
+** Walk the elements of c in order, calling body with each as x. The
+** gaps of consecutive blocks follow each other in bytes, so only the
+** block's first element needs looking up.
+*/
+#define CSET_FOR_EACH(c, x, body) do {					\
+    const uint8_t *p_ = bytes_of(c);					\
+    const int *first_ = first_of(c);					\
+    for (int b_ = 0; b_ < nblocks_of(c); b_++) {			\
+        int x = first_[b_];						\
+        int left_ = (c)->n - b_ * CSET_BLOCK;				\
+        if (left_ > CSET_BLOCK) {					\
+            left_ = CSET_BLOCK;						\
+        }								\
+        body;								\
+        while (--left_ > 0) {						\
+            x += (int)varint_get(&p_);					\
+            body;							\
+        }								\
+    }									\
+} while (0)
+
+/*
+** Write the elements of c to v[0..c->n-1] in ascending order
+*/
+int
+cset_decode(const cset_t *c, int *v) {
+    int k = 0;
+    CSET_FOR_EACH(c, x, v[k++] = x);
+    return k;
+}
+
+/*
+** The number of elements of c that are in U
+*/
+int
+cset_count_bitset(const cset_t *c, const bitset_t *U) {
+    int count = 0;
+    CSET_FOR_EACH(c, x, count += bitset_has(U, x));
+    return count;
+}
+
+/*
+** Remove the elements of c from U
+*/
+void
+cset_remove_bitset(const cset_t *c, bitset_t *U) {
+    CSET_FOR_EACH(c, x, bitset_remove(U, x));
+}
+
+// a position in a set while intersecting
+typedef struct {
+    int n, nblocks;
+    const int *first;
+    const uint32_t *offset;
+    const uint8_t *bytes;
+    int i;			// index of the current element, n when done
+    int x;			// the current element
+    const uint8_t *p;		// the gap of the next element
+} cursor_t;
+
+static inline void
+cursor_block(cursor_t *at, int b) {
+    at->i = b * CSET_BLOCK;
+    at->x = at->first[b];
+    at->p = at->bytes + at->offset[b];
+}
+
+/*
+** A cursor on the first element of c, which must not be empty
+*/
+static inline void
+cursor_start(cursor_t *at, const cset_t *c) {
+    at->n = c->n;
+    at->nblocks = nblocks_of(c);
+    at->first = first_of(c);
+    at->offset = offset_of(c);
+    at->bytes = bytes_of(c);
+    cursor_block(at, 0);
+}
+
+static inline void
+cursor_next(cursor_t *at) {
+    if (++at->i >= at->n) {
+        return;
+    }
+    if (at->i % CSET_BLOCK == 0) {
+        cursor_block(at, at->i / CSET_BLOCK);
+    } else {
+        at->x += (int)varint_get(&at->p);
+    }
+}
+
+/*
+** Move at to the first element at least y, or to the end. The blocks
+** whose first element is at most y are galloped over, the rest of the
+** way is decoded.
+*/
+static inline void
+cursor_seek(cursor_t *at, int y) {
+    if (at->i >= at->n || at->x >= y) {
+        return;
+    }
+    int b = at->i / CSET_BLOCK;
+    if (b + 1 < at->nblocks && at->first[b + 1] <= y) {
+        // first[lo] <= y; step out until first[hi] > y or the end
+        int lo = b + 1, hi = lo + 1, step = 1;
+        while (hi < at->nblocks && at->first[hi] <= y) {
+            lo = hi;
+            step *= 2;
+            hi = lo + step;
+        }
+        if (hi > at->nblocks) {
+            hi = at->nblocks;
+        }
+        while (hi - lo > 1) {
+            int mid = lo + (hi - lo) / 2;
+            if (at->first[mid] <= y) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        cursor_block(at, lo);
+    }
+    while (at->x < y && at->i < at->n) {
+        cursor_next(at);
+    }
+}
+
+/*
+** The first index k >= from with v[k] >= y, or n, galloping from from
+*/
+static inline int
+gallop(const int *v, int n, int from, int y) {
+    if (from >= n || v[from] >= y) {
+        return from;
+    }
+    // v[lo] < y; step out until v[hi] >= y or the end
+    int lo = from, hi = from + 1, step = 1;
+    while (hi < n && v[hi] < y) {
+        lo = hi;
+        step *= 2;
+        hi = lo + step;
+    }
+    if (hi > n) {
+        hi = n;
+    }
+    while (hi - lo > 1) {
+        int mid = lo + (hi - lo) / 2;
+        if (v[mid] < y) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return hi;
+}
+
+/*
+** The number of elements of c among the sorted v[0..n-1]. Whichever
+** side is shorter is walked, galloping over the longer: the packed
+** blocks of c, or v itself.
+*/
+int
+cset_count_sorted(const cset_t *c, const int *v, int n) {
+    cursor_t at;
+    int count = 0, k = 0;
+    if (c->n == 0 || n == 0) {
+        return 0;
+    }
+    cursor_start(&at, c);
+    if (c->n <= n) {
+        for (; at.i < at.n; cursor_next(&at)) {
+            if ((k = gallop(v, n, k, at.x)) == n) {
+                break;
+            }
+            count += v[k] == at.x;
+        }
+        return count;
+    }
+    for (; k < n; k++) {
+        cursor_seek(&at, v[k]);
+        if (at.i >= at.n) {
+            break;
+        }
+        count += at.x == v[k];
+    }
+    return count;
+}
+
+/*
+** Is every element of the sorted v[0..n-1] in c?
+*/
+int
+cset_has_all(const cset_t *c, const int *v, int n) {
+    cursor_t at;
+    if (n > c->n) {
+        return 0;
+    }
+    if (n == 0) {
+        return 1;
+    }
+    cursor_start(&at, c);
+    for (int k = 0; k < n; k++) {
+        cursor_seek(&at, v[k]);
+        if (at.i >= at.n || at.x != v[k]) {
+            return 0;
+        }
+    }
+    return 1;
+}
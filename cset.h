@@ -0,0 +1,29 @@
+/*
+** Compressed Set Module - header file
+** Immutable sets of non-negative integers kept sorted as the gaps between
+** neighbours, each a little-endian base 128 varint (one byte for a gap
+** below 128). Every CSET_BLOCK-th element is also kept whole with the
+** offset of the gaps after it, so a search can skip ahead a block at a
+** time without decoding, and galloping over those is how the sets are
+** intersected with sorted lists.
+*/
+#include <stdint.h>
+
+#define CSET_BLOCK 64		// elements per block, a power of two
+
+// the header is followed in the same allocation by first[nblocks], the
+// elements b * CSET_BLOCK, offset[nblocks], where the gaps after first[b]
+// start, and then the gap bytes themselves, see cset.c
+typedef struct cset {
+    int n;			// number of elements
+    int nbytes;			// gap bytes
+} cset_t;
+
+cset_t *cset_new(const int *v, int n);		// v strictly increasing
+void cset_free(cset_t *c);
+size_t cset_bytes(const cset_t *c);		// memory the set takes
+int  cset_decode(const cset_t *c, int *v);	// write c to v, returns c->n
+int  cset_count_bitset(const cset_t *c, const bitset_t *U);	// |c & U|
+void cset_remove_bitset(const cset_t *c, bitset_t *U);		// U = U - c
+int  cset_count_sorted(const cset_t *c, const int *v, int n);	// |c & v|, v sorted
+int  cset_has_all(const cset_t *c, const int *v, int n);	// is v inside c
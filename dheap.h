@@ -0,0 +1,169 @@
+/*
+** Indexed d-ary Heap - header only
+** DHEAP_DEFINE(Name, Key, Arity) defines the type Name and the functions
+**
+**   Name *Name##Create(uint nindex)   heap for dataIndex < nindex, with
+**                                     room for all of them reserved
+**   void  Name##Destroy(Name *h)
+**   int   Name##Insert(Name *h, uint dataIndex, Key key)
+**   uint  Name##Peek(Name *h)         data index of the root, -1 if empty
+**   Key   Name##PeekKey(Name *h)      key of the root, -1 if empty
+**   uint  Name##RemoveMin(Name *h)    remove the root, return its data index
+**   void  Name##ChangeKey(Name *h, uint dataIndex, Key key)
+**
+** with the same meaning as the binary heap in heap.h (the struct is also
+** tagged Name, so headers can declare pointers to it). The items are kept
+** in one cache line aligned array, offset so that the Arity children of
+** a node share a cache line (for 8-byte items and Arity <= 8), and sifts
+** move a hole rather than swapping, writing each item and its map entry
+** once per level.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#define DHEAP_DEFINE(Name, Key, Arity)                                          \
+typedef struct {                                                                \
+    Key  key;                                                                   \
+    uint dataIndex;                                                             \
+} Name##Item;                                                                   \
+                                                                                \
+typedef struct Name {                                                           \
+    Name##Item *H;      /* item i is at H[i + Arity - 1] */                     \
+    uint *map;          /* map[d] is the position of dataIndex d */             \
+    uint  n;            /* the number of items currently in the heap */         \
+    uint  size;         /* items there is room for */                           \
+    void *block;        /* the allocation H lives in */                         \
+} Name;                                                                         \
+                                                                                \
+static inline Name *                                                            \
+Name##Create(uint nindex) {                                                     \
+    Name *h = (Name *)malloc(sizeof(Name));                                     \
+    if (h == NULL) {                                                            \
+        return NULL;                                                            \
+    }                                                                           \
+    size_t bytes = sizeof(Name##Item) * (nindex + Arity);                       \
+    bytes = (bytes + 63) / 64 * 64;                                             \
+    h->block = aligned_alloc(64, bytes);                                        \
+    h->map = (uint *)malloc(sizeof(uint) * (nindex + 1));                       \
+    if (h->block == NULL || h->map == NULL) {                                   \
+        free(h->block);                                                         \
+        free(h->map);                                                           \
+        free(h);                                                                \
+        return NULL;                                                            \
+    }                                                                           \
+    h->H = (Name##Item *)h->block;                                              \
+    h->n = 0;                                                                   \
+    h->size = nindex;                                                           \
+    return h;                                                                   \
+}                                                                               \
+                                                                                \
+static inline void                                                              \
+Name##Destroy(Name *h) {                                                        \
+    if (h == NULL) {                                                            \
+        return;                                                                 \
+    }                                                                           \
+    free(h->block);                                                             \
+    free(h->map);                                                               \
+    free(h);                                                                    \
+}                                                                               \
+                                                                                \
+/* move the hole at i up until item t fits there, then place t */              \
+static inline void                                                              \
+Name##SiftUp(Name *h, uint i, Name##Item t) {                                   \
+    Name##Item *H = h->H + (Arity - 1);                                         \
+    while (i > 0) {                                                             \
+        uint parent = (i - 1) / Arity;                                          \
+        if (!(H[parent].key > t.key)) {                                         \
+            break;                                                              \
+        }                                                                       \
+        H[i] = H[parent];                                                       \
+        h->map[H[i].dataIndex] = i;                                             \
+        i = parent;                                                             \
+    }                                                                           \
+    H[i] = t;                                                                   \
+    h->map[t.dataIndex] = i;                                                    \
+}                                                                               \
+                                                                                \
+/* move the hole at i down until item t fits there, then place t */            \
+static inline void                                                              \
+Name##SiftDown(Name *h, uint i, Name##Item t) {                                 \
+    Name##Item *H = h->H + (Arity - 1);                                         \
+    for (;;) {                                                                  \
+        uint first = Arity * i + 1, last = first + Arity, best = first;         \
+        if (first >= h->n) {                                                    \
+            break;                                                              \
+        }                                                                       \
+        if (last > h->n) {                                                      \
+            last = h->n;                                                        \
+        }                                                                       \
+        for (uint c = first + 1; c < last; c++) {                               \
+            if (H[c].key < H[best].key) {                                       \
+                best = c;                                                       \
+            }                                                                   \
+        }                                                                       \
+        if (!(t.key > H[best].key)) {                                           \
+            break;                                                              \
+        }                                                                       \
+        H[i] = H[best];                                                         \
+        h->map[H[i].dataIndex] = i;                                             \
+        i = best;                                                               \
+    }                                                                           \
+    H[i] = t;                                                                   \
+    h->map[t.dataIndex] = i;                                                    \
+}                                                                               \
+                                                                                \
+static inline int                                                               \
+Name##Insert(Name *h, uint dataIndex, Key key) {                                \
+    if (h == NULL || h->n == h->size) {                                         \
+        return 0;                                                               \
+    }                                                                           \
+    Name##Item t;                                                               \
+    t.key = key;                                                                \
+    t.dataIndex = dataIndex;                                                    \
+    Name##SiftUp(h, h->n++, t);                                                 \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline uint                                                              \
+Name##Peek(Name *h) {                                                           \
+    return h->n > 0 ? h->H[Arity - 1].dataIndex : (uint)-1;                     \
+}                                                                               \
+                                                                                \
+static inline Key                                                               \
+Name##PeekKey(Name *h) {                                                        \
+    return h->n > 0 ? h->H[Arity - 1].key : (Key)-1;                            \
+}                                                                               \
+                                                                                \
+static inline uint                                                              \
+Name##RemoveMin(Name *h) {                                                      \
+    uint min = Name##Peek(h);                                                   \
+    if (h->n == 0) {                                                            \
+        return min;                                                             \
+    }                                                                           \
+    h->n--;                                                                     \
+    if (h->n > 0) {                                                             \
+        Name##SiftDown(h, 0, h->H[Arity - 1 + h->n]);                           \
+    }                                                                           \
+    return min;                                                                 \
+}                                                                               \
+                                                                                \
+static inline void                                                              \
+Name##ChangeKey(Name *h, uint dataIndex, Key key) {                             \
+    uint i = h->map[dataIndex];                                                 \
+    Name##Item t = h->H[Arity - 1 + i];                                         \
+    Key old = t.key;                                                            \
+    t.key = key;                                                                \
+    if (key < old) {                                                            \
+        Name##SiftUp(h, i, t);                                                  \
+    } else {                                                                    \
+        Name##SiftDown(h, i, t);                                                \
+    }                                                                           \
+}
+
+/*
+** The heap the bounded searches use when Dial's buckets cannot be: qbench
+** times arities 2, 4 and 8, and 4 is as fast as 8 or faster on the sample
+** graphs while keeping sift downs short
+*/
+#define DHEAP_ARITY 4
+DHEAP_DEFINE(DHeap, Distance, DHEAP_ARITY)
@@ -0,0 +1,114 @@
+/*
+** Dial's Bucket Queue
+** Used by the bounded searches when every edge weight is an integer, so
+** every distance, and so every key, is an integer no larger than the
+** radius.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "heap.h"
+#include "dial.h"
+
+/*
+** returns a pointer to a new, empty queue
+*/
+Dial
+*createDial(uint nindex, int maxkey) {
+    assert(maxkey >= 0);
+    Dial *q = (Dial *)malloc(sizeof(Dial));
+    assert(q);
+    q->maxkey = maxkey;
+    q->cur = 0;
+    q->n = 0;
+    q->head = (int *)malloc(sizeof(int) * (maxkey + 1));
+    q->next = (int *)malloc(sizeof(int) * (nindex + 1));
+    q->prev = (int *)malloc(sizeof(int) * (nindex + 1));
+    q->key  = (int *)malloc(sizeof(int) * (nindex + 1));
+    assert(q->head && q->next && q->prev && q->key);
+    for (int k = 0; k <= maxkey; k++) {
+        q->head[k] = -1;
+    }
+    return q;
+}
+
+/*
+** free any memory alloced in queue creation
+*/
+void
+destroyDial(Dial *q) {
+    if (q == NULL) {
+        return;
+    }
+    free(q->head);
+    free(q->next);
+    free(q->prev);
+    free(q->key);
+    free(q);
+}
+
+static inline void
+bucket_link(Dial *q, uint i, int key) {
+    q->key[i] = key;
+    q->prev[i] = -1;
+    q->next[i] = q->head[key];
+    if (q->head[key] >= 0) {
+        q->prev[q->head[key]] = i;
+    }
+    q->head[key] = i;
+}
+
+static inline void
+bucket_unlink(Dial *q, uint i) {
+    if (q->prev[i] >= 0) {
+        q->next[q->prev[i]] = q->next[i];
+    } else {
+        q->head[q->key[i]] = q->next[i];
+    }
+    if (q->next[i] >= 0) {
+        q->prev[q->next[i]] = q->prev[i];
+    }
+}
+
+/*
+** inserts dataIndex with key, which must not be below the last minimum
+*/
+void
+dialInsert(Dial *q, uint dataIndex, int key) {
+    assert(key >= q->cur && key <= q->maxkey);
+    bucket_link(q, dataIndex, key);
+    q->n++;
+}
+
+/*
+** moves a queued dataIndex to key
+*/
+void
+dialChangeKey(Dial *q, uint dataIndex, int key) {
+    assert(key >= q->cur && key <= q->maxkey);
+    bucket_unlink(q, dataIndex);
+    bucket_link(q, dataIndex, key);
+}
+
+/*
+** returns the smallest key queued
+*/
+int
+dialPeekKey(Dial *q) {
+    assert(q->n > 0);
+    while (q->head[q->cur] < 0) {
+        q->cur++;
+    }
+    return q->cur;
+}
+
+/*
+** removes and returns an item with the smallest key
+*/
+uint
+dialRemoveMin(Dial *q) {
+    uint i = q->head[dialPeekKey(q)];
+    bucket_unlink(q, i);
+    q->n--;
+    return i;
+}
@@ -0,0 +1,24 @@
+/*
+** Dial's Bucket Queue - header file
+** A monotone priority queue for small non-negative integer keys: one
+** bucket (a doubly linked list) per key value 0..maxkey. Insert and
+** changeKey are O(1); removeMin scans forward from the last minimum,
+** which is never revisited since keys popped only increase.
+*/
+
+typedef struct dial {
+    int   maxkey;	// keys are 0..maxkey
+    int   cur;		// no bucket below cur is in use
+    uint  n;		// the number of items currently in the queue
+    int  *head;		// head[k] is the first item with key k, or -1
+    int  *next;		// next/prev link the items of one bucket,
+    int  *prev;		// indexed by dataIndex
+    int  *key;		// key[i] is the key of item i while it is queued
+} Dial;
+
+Dial *createDial(uint nindex, int maxkey);	// queue for dataIndex < nindex, keys <= maxkey
+void  destroyDial(Dial *q);
+void  dialInsert(Dial *q, uint dataIndex, int key);
+void  dialChangeKey(Dial *q, uint dataIndex, int key);	// move a queued item to key
+int   dialPeekKey(Dial *q);	// smallest key queued, the queue must not be empty
+uint  dialRemoveMin(Dial *q);	// remove and return an item with the smallest key
@@ -0,0 +1,99 @@
+/*
+** Dijkstra Template
+** The body of the bounded search, written once over a queue policy and
+** included by graph.c for each priority queue. The queue must be empty
+** and over all vertices, and is handed back empty. Before including,
+** define
+**
+**   DIJKSTRA_NAME         name of the function to generate
+**   DIJKSTRA_QUEUE        queue type
+**   Q_PUSH(q, v, d)       queue v with key d
+**   Q_DECREASE(q, v, d)   lower the key of queued v to d
+**   Q_PEEK_KEY(q)         smallest key queued
+**   Q_POP(q)              remove and return a vertex with the smallest key
+**   Q_CLEAR(q)            empty the queue
+**
+** The macros are undefined again at the end. stats.h must be included
+** first, for the counters.
+*/
+
+set_t
+*DIJKSTRA_NAME(Graph *g, Label src, Distance radius, SearchWorkspace *ws, DIJKSTRA_QUEUE *q,
+               Distance **settled) {
+	EdgeIndex i;
+	uint u, v;
+	float d;
+
+	assert(g && g->offsets && ws && q);
+	assert(src >= 0 && src < g->number_of_vertices && g->number_of_vertices <= ws->nvertices);
+
+	// a vertex not stamped with this search's epoch has not been reached,
+	// and its distance is infinity whatever dist holds
+	Distance *dist = ws->dist;
+	uint *stamp = ws->stamp, epoch = search_workspace_epoch(ws);
+	set_t *s = make_empty_set();
+	STAT_DECL(pushes);
+	STAT_DECL(decreases);
+	STAT_DECL(relaxations);
+	dist[src] = 0;
+	stamp[src] = epoch;
+	Q_PUSH(q, src, 0);
+	STAT_INC(pushes);
+
+	while (q->n != 0) {
+		// stop once the closest vertex left is outside the radius
+		if (Q_PEEK_KEY(q) > radius) {
+			break;
+		}
+		u = Q_POP(q);
+		for (i=g->offsets[u];i<g->offsets[u+1];i++) {
+			// the next vertex connected to u
+			STAT_INC(relaxations);
+			v = g->targets[i];
+			d = dist[u] + g->weights[i];
+			if (d > radius) {
+				continue;
+			}
+			if (stamp[v] != epoch) {
+				stamp[v] = epoch;
+				Q_PUSH(q, v, d);
+				STAT_INC(pushes);
+			} else if (d < dist[v]) {
+				// v is still queued, a settled vertex never improves
+				Q_DECREASE(q, v, d);
+				STAT_INC(decreases);
+			} else {
+				continue;
+			}
+			dist[v] = d;
+		}
+		// insert into the set
+		s = insert_at_foot(s, u);
+	}
+
+	if (settled) {
+		*settled = (Distance *)malloc(sizeof(Distance) * (s->n + 1));
+		assert(*settled);
+		i = 0;
+		for (node_t *n = s->head; n != NULL; n = n->next) {
+			(*settled)[i++] = dist[n->data];
+		}
+	}
+	// every settled vertex was popped, the rest are still queued
+	STAT_ADD(STAT_PUSHES, pushes);
+	STAT_ADD(STAT_POPS, s->n);
+	STAT_ADD(STAT_DECREASES, decreases);
+	STAT_ADD(STAT_RELAXATIONS, relaxations);
+	STAT_ADD(STAT_SETTLED, s->n);
+	// the next epoch forgets every distance, only the queue needs emptying
+	Q_CLEAR(q);
+	return s;
+}
+
+#undef DIJKSTRA_NAME
+#undef DIJKSTRA_QUEUE
+#undef Q_PUSH
+#undef Q_DECREASE
+#undef Q_PEEK_KEY
+#undef Q_POP
+#undef Q_CLEAR
@@ -0,0 +1,447 @@
+/*
+** Dynamic Module
+** The coverage of every school is computed once, as compute_coverage
+** does, with each search's distances kept, and inverted into reach[v]:
+** the schools whose ball holds v, and how far away each is. A change to
+** the road a-b can only alter the ball of a school that reaches a or b,
+** and only if
+**   - the road gets shorter (or is added) and takes one end closer than
+**     it was, within the radius, or
+**   - the road gets longer (or is removed) and a shortest path from the
+**     school ran along it (one end is exactly the road's length further
+**     than the other).
+** Those schools are searched again, on the graph as changed, and their
+** entries in reach are replaced. Closing a school only leaves it out of
+** the greedy's candidates, so it can be opened again for nothing.
+**
+** Roads are added into the free slots graph_csr_reserve leaves in the
+** CSR ranges and removed by turning them back into free slots, so the
+** searches run on the same arrays as ever. The edge table finds the
+** slot of any road in constant time.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "solver.h"
+#include "dynamic.h"
+
+#define DYNAMIC_ROOM 2		// free slots given to every vertex to start with
+#define NOWHERE ((Distance)infinity)	// distance of a vertex a school does not reach
+
+// float sums may round either way, so anything this close counts as a
+// tie; the worst that does is run a search that was not needed
+#define NEAR(x, y) ((x) <= (y) + 1e-6f * (y))
+
+/*
+** The key of the directed edge v->u, never 0
+*/
+static inline uint64_t
+edge_key(Label v, Label u) {
+    return ((uint64_t)(uint32_t)v << 32 | (uint32_t)u) + 1;
+}
+
+static inline size_t
+edge_hash(uint64_t key, size_t size) {
+    key ^= key >> 31;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 29;
+    return (size_t)key & (size - 1);
+}
+
+/*
+** The slot of an edge v->u, -1 if there is none
+*/
+static EdgeIndex
+edge_find(edge_table_t *t, Label v, Label u) {
+    uint64_t key = edge_key(v, u);
+    for (size_t i = edge_hash(key, t->size); t->keys[i] != 0; i = (i + 1) & (t->size - 1)) {
+        if (t->keys[i] == key) {
+            return t->slot[i];
+        }
+    }
+    return -1;
+}
+
+static void
+edge_put(edge_table_t *t, uint64_t key, EdgeIndex e) {
+    size_t i = edge_hash(key, t->size);
+    while (t->keys[i] != 0) {
+        i = (i + 1) & (t->size - 1);
+    }
+    t->keys[i] = key;
+    t->slot[i] = e;
+    t->n++;
+}
+
+/*
+** Make the table empty with room for n edges at half load at most
+*/
+static void
+edge_table_init(edge_table_t *t, size_t n) {
+    free(t->keys);
+    free(t->slot);
+    for (t->size = 16; t->size < 2 * n; t->size *= 2)
+        ;
+    t->keys = (uint64_t *)calloc(t->size, sizeof(uint64_t));
+    t->slot = (EdgeIndex *)malloc(sizeof(EdgeIndex) * t->size);
+    assert(t->keys && t->slot);
+    t->n = 0;
+}
+
+static void
+edge_insert(edge_table_t *t, Label v, Label u, EdgeIndex e) {
+    if (2 * (t->n + 1) > t->size) {
+        uint64_t *keys = t->keys;
+        EdgeIndex *slot = t->slot;
+        size_t size = t->size;
+        t->keys = NULL;
+        t->slot = NULL;
+        edge_table_init(t, size);
+        for (size_t i = 0; i < size; i++) {
+            if (keys[i] != 0) {
+                edge_put(t, keys[i], slot[i]);
+            }
+        }
+        free(keys);
+        free(slot);
+    }
+    edge_put(t, edge_key(v, u), e);
+}
+
+/*
+** Take out the entry of v->u at slot e, moving later entries of its
+** probe run back so no lookup passes over an empty entry
+*/
+static void
+edge_remove(edge_table_t *t, Label v, Label u, EdgeIndex e) {
+    uint64_t key = edge_key(v, u);
+    size_t mask = t->size - 1, i = edge_hash(key, t->size);
+    while (t->keys[i] != key || t->slot[i] != e) {
+        assert(t->keys[i] != 0);
+        i = (i + 1) & mask;
+    }
+    for (size_t j = (i + 1) & mask; t->keys[j] != 0; j = (j + 1) & mask) {
+        size_t h = edge_hash(t->keys[j], t->size);
+        // the entry at j may fill the hole at i unless its home lies
+        // cyclically in (i, j]
+        if (((j - h) & mask) >= ((j - i) & mask)) {
+            t->keys[i] = t->keys[j];
+            t->slot[i] = t->slot[j];
+            i = j;
+        }
+    }
+    t->keys[i] = 0;
+    t->n--;
+}
+
+/*
+** Index every edge of the graph (after its slots have moved)
+*/
+static void
+edge_table_fill(dynamic_t *d) {
+    Graph *g = d->g;
+    edge_table_init(&d->edges, g->num_edges);
+    for (Label v = 0; v < g->number_of_vertices; v++) {
+        for (EdgeIndex e = g->offsets[v]; e < g->offsets[v+1]; e++) {
+            if (g->weights[e] != GRAPH_NO_EDGE) {
+                edge_put(&d->edges, edge_key(v, g->targets[e]), e);
+            }
+        }
+    }
+}
+
+static void
+reach_add(reach_list_t *l, int school, Distance dist) {
+    if (l->n == l->size) {
+        l->size = l->size ? 2 * l->size : 4;
+        l->r = (reach_t *)realloc(l->r, sizeof(reach_t) * l->size);
+        assert(l->r);
+    }
+    l->r[l->n].school = school;
+    l->r[l->n].dist = dist;
+    l->n++;
+}
+
+static void
+reach_remove(reach_list_t *l, int school) {
+    for (int k = 0; k < l->n; k++) {
+        if (l->r[k].school == school) {
+            l->r[k] = l->r[--l->n];
+            return;
+        }
+    }
+}
+
+/*
+** Put the coverage of school s into reach
+*/
+static void
+reach_school(dynamic_t *d, int s) {
+    int k = 0;
+    for (node_t *n = d->all_set[s]->head; n != NULL; n = n->next) {
+        reach_add(&d->reach[n->data], s, d->all_dist[s][k++]);
+    }
+}
+
+/*
+** Keep the coverage of radius around every school of g up to date
+** under changes. The graph is changed in place as the roads are.
+*/
+dynamic_t
+*dynamic_new(Graph *g, Distance radius, int queue, int nworkers) {
+    dynamic_t *d = (dynamic_t *)calloc(1, sizeof(dynamic_t));
+    assert(d);
+    d->g = g;
+    d->radius = radius;
+    d->queue = queue;
+    d->nworkers = nworkers;
+    graph_csr_reserve(g, -1, DYNAMIC_ROOM);
+    edge_table_fill(d);
+
+    d->all_set = (set_t **)malloc(sizeof(set_t *) * (g->S + 1));
+    d->all_dist = (Distance **)malloc(sizeof(Distance *) * (g->S + 1));
+    assert(d->all_set && d->all_dist);
+    compute_coverage(g, d->all_set, d->all_dist, radius, queue, nworkers);
+    d->reach = (reach_list_t *)calloc(g->number_of_vertices, sizeof(reach_list_t));
+    assert(d->reach);
+    for (int s = 0; s < g->S; s++) {
+        reach_school(d, s);
+    }
+
+    d->closed = (char *)calloc(g->S + 1, 1);
+    d->mark = (int *)calloc(g->S + 1, sizeof(int));
+    d->other = (Distance *)malloc(sizeof(Distance) * (g->S + 1));
+    d->todo = (int *)malloc(sizeof(int) * (g->S + 1));
+    d->ws = search_workspace_new(g->number_of_vertices, queue, radius);
+    assert(d->closed && d->mark && d->other && d->todo && d->ws);
+    return d;
+}
+
+void
+dynamic_free(dynamic_t *d) {
+    if (d == NULL) {
+        return;
+    }
+    for (int s = 0; s < d->g->S; s++) {
+        free_set(d->all_set[s]);
+        free(d->all_dist[s]);
+    }
+    for (int v = 0; v < d->g->number_of_vertices; v++) {
+        free(d->reach[v].r);
+    }
+    free(d->all_set);
+    free(d->all_dist);
+    free(d->reach);
+    free(d->edges.keys);
+    free(d->edges.slot);
+    free(d->closed);
+    free(d->mark);
+    free(d->other);
+    free(d->todo);
+    search_workspace_free(d->ws);
+    free(d);
+}
+
+/*
+** Could a school da from a and db from b find its ball changed when the
+** road a-b goes from length wo to wn (either NOWHERE for no road)?
+*/
+static int
+road_matters(Distance radius, Distance da, Distance db, Distance wo, Distance wn) {
+    if (wn < wo) {
+        // shorter: does it take either end closer, within the radius?
+        Distance via_a = da + wn, via_b = db + wn;
+        return (NEAR(via_a, radius) && via_a < db + 1e-6f * db)
+            || (NEAR(via_b, radius) && via_b < da + 1e-6f * da);
+    }
+    // longer: was it on a shortest path to either end?
+    Distance via_a = da + wo, via_b = db + wo;
+    return (NEAR(via_a, radius) && NEAR(via_a, db))
+        || (NEAR(via_b, radius) && NEAR(via_b, da));
+}
+
+/*
+** Put in todo the schools whose ball may change with the road a-b going
+** from length wo to wn. return how many there are
+*/
+static int
+find_affected(dynamic_t *d, Label a, Label b, Distance wo, Distance wn) {
+    reach_list_t *ra = &d->reach[a], *rb = &d->reach[b];
+    int n = 0, known = ++d->stamp, done = ++d->stamp;
+    for (int k = 0; k < rb->n; k++) {
+        d->mark[rb->r[k].school] = known;
+        d->other[rb->r[k].school] = rb->r[k].dist;
+    }
+    for (int k = 0; k < ra->n; k++) {
+        int s = ra->r[k].school;
+        Distance db = d->mark[s] == known ? d->other[s] : NOWHERE;
+        d->mark[s] = done;
+        if (road_matters(d->radius, ra->r[k].dist, db, wo, wn)) {
+            d->todo[n++] = s;
+        }
+    }
+    for (int k = 0; k < rb->n; k++) {
+        int s = rb->r[k].school;
+        if (d->mark[s] != done && road_matters(d->radius, NOWHERE, rb->r[k].dist, wo, wn)) {
+            d->todo[n++] = s;
+        }
+    }
+    return n;
+}
+
+/*
+** Search again from the n schools in todo, on the graph as it is now
+*/
+static int
+search_again(dynamic_t *d, int n) {
+    for (int i = 0; i < n; i++) {
+        int s = d->todo[i];
+        for (node_t *x = d->all_set[s]->head; x != NULL; x = x->next) {
+            reach_remove(&d->reach[x->data], s);
+        }
+        free_set(d->all_set[s]);
+        free(d->all_dist[s]);
+        d->all_set[s] = dijkstra_search(d->g, d->g->H + s, d->radius, d->ws, &d->all_dist[s]);
+        reach_school(d, s);
+    }
+    d->searches += n;
+    return n;
+}
+
+/*
+** Put the directed edge v->u of length dist in a free slot of v,
+** making room if v has none
+*/
+static void
+add_arc(dynamic_t *d, Label v, Label u, Distance dist) {
+    Graph *g = d->g;
+    EdgeIndex e = graph_csr_free_slot(g, v);
+    if (e < 0) {
+        // double v's range, so a vertex that keeps gaining roads makes
+        // the arrays be rebuilt only a logarithmic number of times
+        EdgeIndex slots = g->offsets[v+1] - g->offsets[v];
+        graph_csr_reserve(g, v, slots > DYNAMIC_ROOM ? (int)slots : DYNAMIC_ROOM);
+        edge_table_fill(d);
+        e = graph_csr_free_slot(g, v);
+    }
+    g->targets[e] = u;
+    g->weights[e] = dist;
+    edge_insert(&d->edges, v, u, e);
+}
+
+static void
+del_arc(dynamic_t *d, Label v, Label u) {
+    Graph *g = d->g;
+    EdgeIndex e = edge_find(&d->edges, v, u);
+    if (e >= 0) {
+        edge_remove(&d->edges, v, u, e);
+        g->targets[e] = v;
+        g->weights[e] = GRAPH_NO_EDGE;
+    }
+}
+
+int
+dynamic_has_edge(dynamic_t *d, Label v, Label u) {
+    if (v < 0 || v >= d->g->number_of_vertices || u < 0 || u >= d->g->number_of_vertices) {
+        return 0;
+    }
+    return edge_find(&d->edges, v, u) >= 0;
+}
+
+/*
+** Add the road v-u of length dist, or change its length if it is there.
+** return the number of searches run again, -1 if it is not a road
+*/
+int
+dynamic_set_edge(dynamic_t *d, Label v, Label u, Distance dist) {
+    Graph *g = d->g;
+    if (v < 0 || v >= g->number_of_vertices || u < 0 || u >= g->number_of_vertices
+        || v == u || !(dist >= 0) || dist >= GRAPH_NO_EDGE) {
+        return -1;
+    }
+    if (d->queue == QUEUE_DIAL && dist < DIAL_MAX_RADIUS && dist != (Distance)(int)dist) {
+        // Dial's buckets need whole lengths from now on
+        search_workspace_free(d->ws);
+        d->queue = QUEUE_DHEAP;
+        d->ws = search_workspace_new(g->number_of_vertices, d->queue, d->radius);
+        assert(d->ws);
+    }
+    EdgeIndex e = edge_find(&d->edges, v, u);
+    Distance old = e < 0 ? GRAPH_NO_EDGE : g->weights[e];
+    if (old == dist) {
+        return 0;
+    }
+    int n = find_affected(d, v, u, old, dist);
+    if (e < 0) {
+        add_arc(d, v, u, dist);
+        add_arc(d, u, v, dist);
+    } else {
+        g->weights[e] = dist;
+        if ((e = edge_find(&d->edges, u, v)) >= 0) {
+            g->weights[e] = dist;
+        }
+    }
+    return search_again(d, n);
+}
+
+/*
+** Remove the road v-u (one copy of it, if there are more).
+** return the number of searches run again, -1 if there is no such road
+*/
+int
+dynamic_del_edge(dynamic_t *d, Label v, Label u) {
+    if (!dynamic_has_edge(d, v, u)) {
+        return -1;
+    }
+    Distance old = d->g->weights[edge_find(&d->edges, v, u)];
+    int n = find_affected(d, v, u, old, NOWHERE);
+    del_arc(d, v, u);
+    del_arc(d, u, v);
+    return search_again(d, n);
+}
+
+/*
+** Make school (0 for vertex H) a candidate or not.
+** return 0, -1 if there is no such school
+*/
+int
+dynamic_set_school(dynamic_t *d, int school, int open) {
+    if (school < 0 || school >= d->g->S) {
+        return -1;
+    }
+    d->closed[school] = !open;
+    return 0;
+}
+
+/*
+** Solve the set cover over the open schools, as solve_radius does, at a
+** radius no larger than the one the coverage is kept for
+*/
+int
+*dynamic_solve(dynamic_t *d, Distance radius, int greedy, int prune, int essential,
+               int stats, int *num) {
+    Graph *g = d->g;
+    assert(radius <= d->radius);
+    set_t **sets = (set_t **)malloc(sizeof(set_t *) * (g->S + 1));
+    Distance **dists = (Distance **)malloc(sizeof(Distance *) * (g->S + 1));
+    assert(sets && dists);
+    // a closed school is no candidate at all, not one covering nothing,
+    // which the greedy could still end on
+    int n = 0;
+    for (int s = 0; s < g->S; s++) {
+        if (!d->closed[s]) {
+            sets[n] = d->all_set[s];
+            dists[n++] = d->all_dist[s];
+        }
+    }
+    int *A = solve_radius(g, sets, dists, n, radius, greedy, prune, essential,
+                          d->nworkers, stats, num);
+    free(sets);
+    free(dists);
+    return A;
+}
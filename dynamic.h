@@ -0,0 +1,55 @@
+/*
+** Dynamic Module - header file
+** Keeps the coverage of every school up to date while roads are added,
+** removed and reweighted and schools are opened and closed, so a planner
+** can solve again after each change without starting over. A change to
+** the road v-u only runs again the searches whose ball within the radius
+** holds v or u and could use the road, which the index of which schools
+** reach each vertex tells without searching. The greedy then runs on the
+** cached coverage.
+*/
+
+// a school whose ball holds a vertex, and how far it is from it
+typedef struct {
+    int school;			// 0 for vertex H
+    Distance dist;
+} reach_t;
+
+typedef struct {
+    reach_t *r;
+    int n, size;
+} reach_list_t;
+
+// where each directed edge lives in the CSR arrays, by its two ends
+typedef struct {
+    uint64_t *keys;		// 0 for an empty entry, see edge_key
+    EdgeIndex *slot;
+    size_t size, n;		// size is a power of two
+} edge_table_t;
+
+typedef struct {
+    Graph *g;
+    Distance radius;		// every search runs out to this
+    int queue;			// the searches' queue, see choose_queue
+    int nworkers;		// threads for the first searches and the greedy
+    set_t **all_set;		// all_set[i], all_dist[i] as compute_coverage gives
+    Distance **all_dist;	// them, for school i
+    char *closed;		// closed[i] if school i is not a candidate
+    reach_list_t *reach;	// reach[v] lists the schools whose ball holds v
+    edge_table_t edges;
+    SearchWorkspace *ws;	// for the searches run again
+    int *mark;			// per school scratch for finding the affected
+    Distance *other;
+    int stamp;
+    int *todo;
+    long searches;		// searches run again, over every change
+} dynamic_t;
+
+dynamic_t *dynamic_new(Graph *g, Distance radius, int queue, int nworkers);
+void dynamic_free(dynamic_t *d);		// the graph is left to the caller
+int  dynamic_has_edge(dynamic_t *d, Label v, Label u);
+int  dynamic_set_edge(dynamic_t *d, Label v, Label u, Distance dist);
+int  dynamic_del_edge(dynamic_t *d, Label v, Label u);
+int  dynamic_set_school(dynamic_t *d, int school, int open);
+int *dynamic_solve(dynamic_t *d, Distance radius, int greedy, int prune, int essential,
+                   int stats, int *num);
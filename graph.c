@@ -1,7 +1,7 @@
 /*
 ** Graph Module
 ** Uses an adjacency list representation (arrays for lists).
-** 
+** graph_build_csr() builds the CSR arrays for the searches from an edge list.
 **
 ** Attributed from Andrew Turpin
 ** 
@@ -10,9 +10,14 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
 #include "graph.h"
-#include "set.h"
 #include "heap.h"
+#include "set.h"
+#include "dial.h"
+#include "dheap.h"
+#include "stats.h"
 
 
 /*
@@ -28,6 +33,12 @@ graph_new(int number_of_vertices) {
     g->number_of_vertices = number_of_vertices;
     g->vertices = (Vertex *)malloc(sizeof(Vertex) * number_of_vertices);
     assert(g->vertices);
+    g->num_edges = 0;
+    g->offsets = NULL;
+    g->targets = NULL;
+    g->weights = NULL;
+    g->mapped = NULL;
+    g->mapped_bytes = 0;
     
     /*initialise all the data*/
     for(int i = 0 ; i < number_of_vertices ; i++) {
@@ -49,6 +60,7 @@ graph_add_edge(Graph *g, Label v, Label u, Distance dist) {
     assert(g);
     assert(v >= 0 && v < g->number_of_vertices);
     assert(u >= 0 && u < g->number_of_vertices);
+    assert(g->offsets == NULL); // the CSR form is read only
 
         // Make room if no room.
     if (g->vertices[v].num_edges == g->vertices[v].max_num_edges) {
@@ -74,20 +86,20 @@ graph_del_edge(Graph *g, Label v, Label u) {
     assert(g);
     assert(v >= 0 && v < g->number_of_vertices);
     assert(u >= 0 && u < g->number_of_vertices);
+    assert(g->offsets == NULL); // the CSR form is read only
 
-    int i;
+    int i, n = g->vertices[v].num_edges;
+    Edge *edges = g->vertices[v].edges;
 
-    for(i = 0 ; i < g->vertices[v].num_edges
-    	    && g->vertices[v].edges[i].u != u ; i++) {
-    	if (i == g->vertices[v].num_edges) // not there
-    		return;
-    }
+    for(i = 0 ; i < n && edges[i].u != u ; i++)
+        ;
+    if (i == n) // not there
+        return;
 
-    for( ; i < g->vertices[v].num_edges - 1 ; i++) {
-    	// move remainder to the left to fill hole at i
-        g->vertices[v].edges[i] = g->vertices[v].edges[i+1];
-        g->vertices[v].num_edges -= 1;
-    }
+    // move the remainder to the left to fill the hole at i, keeping the
+    // order the edges were added in
+    memmove(edges + i, edges + i + 1, sizeof(Edge) * (n - i - 1));
+    g->vertices[v].num_edges = n - 1;
 }
 /*
 ** Return pointer to start of edge array for vertex v
@@ -97,6 +109,7 @@ Edge *
 graph_get_edge_array(Graph *g, Label v, int *num_edges) {
     assert(g);
     assert(v >= 0 && v < g->number_of_vertices);
+    assert(g->offsets == NULL); // the lists are not kept alongside the CSR form
 
     *num_edges = g->vertices[v].num_edges;
 
@@ -112,6 +125,12 @@ graph_has_edge(Graph *g, Label v, Label u) {
     assert(v >= 0 && v < g->number_of_vertices);
     assert(u >= 0 && u < g->number_of_vertices);
     
+    if (g->offsets) {
+        for(EdgeIndex i = g->offsets[v] ; i < g->offsets[v+1] ; i++)
+            if (g->targets[i] == u && g->weights[i] != GRAPH_NO_EDGE)
+                return 1;
+        return 0;
+    }
     for(int i = 0 ; i < g->vertices[v].num_edges ; i++)
         if (g->vertices[v].edges[i].u == u)
             return 1;
@@ -133,64 +152,110 @@ graph_set_vertex_data(Graph *g, Label v, Status visited) {
 
 
 /*
-** Simple explore for calling from dfs in check_graph function
-** calculates the number of vertices in the graph and checks that
-** the graph is undirected
+** Explore for calling from check_graph and graph_components.
+** Visits everything reachable from v with an explicit stack rather than
+** recursion (long path-like road networks would overflow the call
+** stack), marking each vertex reached with component[u] = id.
+** The visited state is kept in component[] (-1 for not yet reached), not
+** in the graph, so the graph can be shared read only.
+** stack must have room for number_of_vertices labels.
+** return the number of vertices newly reached
 */
-void 
-graph_explore(Graph *g, Label v, int *nvertex) {
-    if (g->vertices[v].visited) {
-        return;
-    }
-
-    g->vertices[v].visited = 1; // mark as visited
-    (*nvertex)++; // count the number of times a vertex has be marked visited
-    for(int i = 0 ; i < g->vertices[v].num_edges ; i++) {
-        graph_explore(g, g->vertices[v].edges[i].u, nvertex);
-    }
+int
+graph_explore(Graph *g, Label v, int *component, int id, Label *stack) {
+	int top = 0, nvertex = 0;
+	if (component[v] >= 0) {
+		return 0;
+	}
+	component[v] = id;
+	stack[top++] = v;
+	while (top > 0) {
+		Label u = stack[--top];
+		nvertex++;
+		for (EdgeIndex i = g->offsets[u]; i < g->offsets[u+1]; i++) {
+			Label w = g->targets[i];
+			// mark on push so each vertex is on the stack at most once
+			if (component[w] < 0) {
+				component[w] = id;
+				stack[top++] = w;
+			}
+		}
+	}
+	return nvertex;
 }
 
 /*
-** Input the the verteces and distances into the graph structure
+** Label every vertex with its connected component, numbered from 0 in
+** order of each component's lowest vertex.
+** return the number of components
 */
-Graph
-*input_graph(void) {
-	int num_vertex, H, S, dist;
-	Graph *g;
-	Label v, u;
-	// first two row is the number of house and school vertices
-	scanf("%d", &H);
-	scanf("%d", &S);
-	num_vertex = H + S;
-	g = graph_new(num_vertex);
-	g->H = H;
-	g->S = S;
-	while (scanf("%d %d %d", &v, &u, &dist)==3) {
-		graph_add_edge(g, v, u, dist);
-		graph_add_edge(g, u, v, dist);
+int
+graph_components(Graph *g, int *component) {
+	assert(g && g->offsets && component);
+	int ncomponent = 0;
+	Label *stack = (Label *)malloc(sizeof(Label) * g->number_of_vertices);
+	assert(stack);
+	for (int i = 0; i < g->number_of_vertices; i++) {
+		component[i] = -1;
+	}
+	for (int i = 0; i < g->number_of_vertices; i++) {
+		if (component[i] < 0) {
+			graph_explore(g, i, component, ncomponent++, stack);
+		}
 	}
-	return g;
+	free(stack);
+	return ncomponent;
 }
 
 /*
 ** Checks if the graph is fully connected
-** Perform DFS beginning at v.
-** ASSUMES vertex->data is 1 or 0 for visited and unvisted
+** Explores from v, which must then reach every vertex.
 */
 int
 check_graph(Graph *g, Label v) {
-	assert(g);
+	assert(g && g->offsets);
 	assert(v >= 0 && v < g->number_of_vertices);
-	int nvertex=0;
-        // first explore from v
-        // if the graph is fully connected only one explore should be called
-        graph_explore(g, v, &nvertex);
-        // nvertex from explore should be the same as input if fully connected
-        if (nvertex==g->number_of_vertices) {
-        	return 1;
-        } else {
-        	return 0;
-        }
+	int *component = (int *)malloc(sizeof(int) * g->number_of_vertices);
+	Label *stack = (Label *)malloc(sizeof(Label) * g->number_of_vertices);
+	assert(component && stack);
+	for (int i = 0; i < g->number_of_vertices; i++) {
+		component[i] = -1;
+	}
+	// nvertex from explore should be the same as input if fully connected
+	int nvertex = graph_explore(g, v, component, 0, stack);
+	free(component);
+	free(stack);
+	return nvertex == g->number_of_vertices;
+}
+
+/*
+** Say why a graph failed check_graph(g, v): how many components it has
+** and which houses cannot be reached from v (at most limit of them
+** listed, all of them if limit is 0)
+*/
+void
+graph_report_unreachable(Graph *g, Label v, FILE *fp, int limit) {
+	int *component = (int *)malloc(sizeof(int) * g->number_of_vertices);
+	assert(component);
+	int ncomponent = graph_components(g, component);
+	int nunreachable = 0;
+	for (int i = 0; i < g->H; i++) {
+		nunreachable += component[i] != component[v];
+	}
+	fprintf(fp, "components: %d\n", ncomponent);
+	fprintf(fp, "houses unreachable from vertex %d: %d\n", v, nunreachable);
+	int listed = 0;
+	for (int i = 0; i < g->H && (limit == 0 || listed < limit); i++) {
+		if (component[i] != component[v]) {
+			fprintf(fp, "%s%d", listed ? " " : "unreachable houses: ", i);
+			listed++;
+		}
+	}
+	if (listed) {
+		fprintf(fp, nunreachable > listed ? " ... (%d more)\n" : "\n",
+		        nunreachable - listed);
+	}
+	free(component);
 }
 
 void 
@@ -198,6 +263,14 @@ graph_print(Graph *g) {
 	int i, j;
 	for (i = 0; i < g->number_of_vertices; i++) {
 		printf("Label is: %d\n", g->vertices[i].label);
+		if (g->offsets) {
+			printf("Number of Edges: %d\n", (int)(g->offsets[i+1] - g->offsets[i]));
+			for (EdgeIndex e = g->offsets[i]; e < g->offsets[i+1]; e++) {
+				printf("Edge label connected: %d, Distance: %f meters\n",
+				        g->targets[e], g->weights[e]);
+			}
+			continue;
+		}
 		printf("Number of Edges: %d\n", g->vertices[i].num_edges);
 		for (j = 0; j < g->vertices[i].num_edges; j++) {
 			printf("Edge label connected: %d, Distance: %f meters\n", 
@@ -212,10 +285,153 @@ graph_print(Graph *g) {
 void
 free_graph(Graph *g) {
 	assert(g);
+	for (int i = 0; i < g->number_of_vertices; i++) {
+		free(g->vertices[i].edges);
+	}
 	free(g->vertices);
+	if (g->mapped) {
+		munmap(g->mapped, g->mapped_bytes);
+	} else {
+		free(g->offsets);
+		free(g->targets);
+		free(g->weights);
+	}
 	free(g);
 }
 
+/*
+** Build the CSR form straight from an edge list, without going through
+** the adjacency lists: edge i joins from[i] and to[i] in both directions.
+** The edges of each vertex come out in the order they are given, as
+** graph_add_edge would keep them.
+*/
+void
+graph_build_csr(Graph *g, EdgeIndex m, const Label *from, const Label *to, const Distance *dist) {
+	EdgeIndex i;
+	int nv = g->number_of_vertices;
+	assert(g && g->offsets == NULL);
+	assert(m >= 0 && m <= EDGE_INDEX_MAX / 2);
+
+	g->num_edges = 2 * m;
+	g->offsets = (EdgeIndex *)calloc(nv + 1, sizeof(EdgeIndex));
+	g->targets = (Label *)malloc(sizeof(Label) * (g->num_edges + 1));
+	g->weights = (Distance *)malloc(sizeof(Distance) * (g->num_edges + 1));
+	assert(g->offsets && g->targets && g->weights);
+
+	// count the degrees, then turn offsets[v+1] into the start of v+1
+	for (i = 0; i < m; i++) {
+		g->offsets[from[i] + 1]++;
+		g->offsets[to[i] + 1]++;
+	}
+	for (i = 0; i < nv; i++) {
+		g->vertices[i].num_edges = g->offsets[i + 1];
+		g->offsets[i + 1] += g->offsets[i];
+	}
+	// place the edges, using offsets[v] as v's insertion point
+	for (i = 0; i < m; i++) {
+		EdgeIndex k = g->offsets[from[i]]++;
+		g->targets[k] = to[i];
+		g->weights[k] = dist[i];
+		k = g->offsets[to[i]]++;
+		g->targets[k] = from[i];
+		g->weights[k] = dist[i];
+	}
+	// each offsets[v] now holds the start of v+1, shift them back
+	for (i = nv; i > 0; i--) {
+		g->offsets[i] = g->offsets[i - 1];
+	}
+	g->offsets[0] = 0;
+}
+
+/*
+** Make room to add edges to a frozen graph: afterwards vertex v (every
+** vertex if v < 0) has at least room free slots in its range of the CSR
+** arrays. A free slot is an edge from the vertex to itself of length
+** GRAPH_NO_EDGE, which no bounded search ever takes. Each vertex keeps
+** its edges in order, then its free slots. The arrays are rebuilt, so
+** edges move; a mapped graph is copied out of its file.
+*/
+void
+graph_csr_reserve(Graph *g, Label v, int room) {
+	int nv = g->number_of_vertices;
+	assert(g && g->offsets && v < nv && room >= 0);
+
+	// the new size of every range, as the start of the next one
+	EdgeIndex *offsets = (EdgeIndex *)malloc(sizeof(EdgeIndex) * (nv + 1));
+	assert(offsets);
+	offsets[0] = 0;
+	for (int x = 0; x < nv; x++) {
+		EdgeIndex used = 0, slots = g->offsets[x+1] - g->offsets[x];
+		for (EdgeIndex e = g->offsets[x]; e < g->offsets[x+1]; e++) {
+			used += g->weights[e] != GRAPH_NO_EDGE;
+		}
+		if ((v < 0 || x == v) && slots - used < room) {
+			slots = used + room;
+		}
+		assert(offsets[x] <= EDGE_INDEX_MAX - slots);
+		offsets[x+1] = offsets[x] + slots;
+	}
+	EdgeIndex m = offsets[nv];
+	Label *targets = (Label *)malloc(sizeof(Label) * (m + 1));
+	Distance *weights = (Distance *)malloc(sizeof(Distance) * (m + 1));
+	assert(targets && weights);
+	for (int x = 0; x < nv; x++) {
+		EdgeIndex k = offsets[x];
+		for (EdgeIndex e = g->offsets[x]; e < g->offsets[x+1]; e++) {
+			if (g->weights[e] != GRAPH_NO_EDGE) {
+				targets[k] = g->targets[e];
+				weights[k++] = g->weights[e];
+			}
+		}
+		for (; k < offsets[x+1]; k++) {
+			targets[k] = x;
+			weights[k] = GRAPH_NO_EDGE;
+		}
+	}
+
+	if (g->mapped) {
+		munmap(g->mapped, g->mapped_bytes);
+		g->mapped = NULL;
+		g->mapped_bytes = 0;
+	} else {
+		free(g->offsets);
+		free(g->targets);
+		free(g->weights);
+	}
+	g->offsets = offsets;
+	g->targets = targets;
+	g->weights = weights;
+	g->num_edges = m;
+}
+
+/*
+** return a free slot in v's range of the CSR arrays, -1 if it has none
+*/
+EdgeIndex
+graph_csr_free_slot(Graph *g, Label v) {
+	assert(g && g->offsets);
+	assert(v >= 0 && v < g->number_of_vertices);
+	for (EdgeIndex e = g->offsets[v]; e < g->offsets[v+1]; e++) {
+		if (g->weights[e] == GRAPH_NO_EDGE) {
+			return e;
+		}
+	}
+	return -1;
+}
+
+/*
+** Bytes held by the CSR arrays
+*/
+size_t
+graph_csr_bytes(Graph *g) {
+	assert(g);
+	if (g->offsets == NULL) {
+		return 0;
+	}
+	return sizeof(EdgeIndex) * (g->number_of_vertices + 1)
+	     + (sizeof(Label) + sizeof(Distance)) * g->num_edges;
+}
+
 /*
 ** Using dijkstra algorithm to obtain vertices shortest distance
 ** to the source and put into heap priority queue
@@ -223,43 +439,171 @@ free_graph(Graph *g) {
 */
 set_t
 *dijkstra(Graph *g, Label src) {
-	int i;
-	float dist[g->number_of_vertices];
-	uint u, v;
-	
-	// initialise all distances to infinity
-	Heap *h = createHeap();
-	set_t *s = make_empty_set();
-	for (i=0;i<g->number_of_vertices;i++) {
-		dist[i] = infinity;
-		
-		if (!insert(h, g->vertices[i].label, infinity)) {
-			fprintf(stderr, "Heap not inserted successfully\n");
-		}
+	return dijkstra_bounded(g, src, COVER_RADIUS, NULL);
+}
+
+/*
+** Radius-bounded lazy dijkstra
+** Vertices only enter the priority queue when they are first reached,
+** keys are only decreased on a real improvement, and the search stops
+** as soon as the nearest unsettled vertex is beyond radius, so the work
+** done depends on the size of the neighbourhood rather than on |V|.
+** Returns the set of vertices within radius of src in the order they
+** were settled (src first).
+** Repeated calls should share a workspace of the caller's, as
+** compute_coverage does, so they allocate nothing beyond the returned
+** set; with ws NULL one is made for this search and freed after it.
+*/
+set_t
+*dijkstra_bounded(Graph *g, Label src, Distance radius, SearchWorkspace *ws) {
+	if (ws != NULL) {
+		assert(ws->nvertices >= g->number_of_vertices);
+		return dijkstra_search(g, src, radius, ws, NULL);
 	}
-	// set the source distance to 0
-	changeKey(h, src, 0);
-	dist[src] = 0;
-	
-	while (h->n != 0) {
-		// pop the min edge from the queue to explore
-		u = removeMin(h);
-		// early termination if the distance is bigger than 1km
-		if (h->H[h->map[u]].key > 1000) {
-			return s;
-		}
-		for (i=0;i<g->vertices[u].num_edges;i++) {
-			// the next vertex connected to u
-			v = g->vertices[u].edges[i].u;
-			if (dist[v] > dist[u] + g->vertices[u].edges[i].dist) {
-				dist[v] = dist[u] + g->vertices[u].edges[i].dist;
-			}
-			// update priority queue
-			changeKey(h, v, dist[v]);
+	ws = search_workspace_new(g->number_of_vertices, QUEUE_DHEAP, radius);
+	assert(ws);
+	set_t *s = dijkstra_search(g, src, radius, ws, NULL);
+	search_workspace_free(ws);
+	return s;
+}
+
+/*
+** A workspace for bounded searches on graphs of up to nvertices
+** vertices, with a queue of the given kind (for QUEUE_DIAL, radius is
+** the largest radius it can search). Returns NULL if out of memory.
+*/
+SearchWorkspace
+*search_workspace_new(int nvertices, int queue, Distance radius) {
+	SearchWorkspace *ws = (SearchWorkspace *)malloc(sizeof(SearchWorkspace));
+	if (ws == NULL) {
+		return NULL;
+	}
+	ws->nvertices = nvertices;
+	ws->queue = queue;
+	ws->heap = NULL;
+	ws->dial = NULL;
+	ws->dheap = NULL;
+	if (queue == QUEUE_DIAL) {
+		ws->dial = createDial(nvertices, (int)radius);
+	} else if (queue == QUEUE_DHEAP) {
+		ws->dheap = DHeapCreate(nvertices);
+	} else {
+		ws->queue = QUEUE_HEAP;
+		ws->heap = createIndexedHeap(nvertices);
+	}
+	ws->dist = (Distance *)malloc(sizeof(Distance) * (nvertices + 1));
+	// zeroed stamps are older than any epoch handed out
+	ws->stamp = (uint *)calloc(nvertices + 1, sizeof(uint));
+	ws->epoch = 0;
+	if ((ws->heap == NULL && ws->dial == NULL && ws->dheap == NULL)
+	    || ws->dist == NULL || ws->stamp == NULL) {
+		search_workspace_free(ws);
+		return NULL;
+	}
+	return ws;
+}
+
+void
+search_workspace_free(SearchWorkspace *ws) {
+	if (ws == NULL) {
+		return;
+	}
+	destroyHeap(ws->heap);
+	destroyDial(ws->dial);
+	DHeapDestroy(ws->dheap);
+	free(ws->dist);
+	free(ws->stamp);
+	free(ws);
+}
+
+/*
+** Start a new search on ws: the epoch it returns has stamped no vertex
+** yet. When the counter wraps the stamps are cleared, once every 2^32
+** searches.
+*/
+uint
+search_workspace_epoch(SearchWorkspace *ws) {
+	if (++ws->epoch == 0) {
+		memset(ws->stamp, 0, sizeof(uint) * (ws->nvertices + 1));
+		ws->epoch = 1;
+	}
+	return ws->epoch;
+}
+
+/*
+** The bounded search on a workspace, one per thread, reused for many
+** sources with a per-source cost that does not depend on |V|.
+** If settled is not NULL it is set to a new array holding the distance
+** of each vertex of the returned set, in the same (nondecreasing) order,
+** so the set for any smaller radius is a prefix of this one.
+**
+** dijkstra_search runs on the workspace's own queue. The others take the
+** queue as well, which must be empty and over all vertices:
+** dijkstra_search_heap runs on the binary heap and works for any weights.
+** dijkstra_search_dial runs on Dial's buckets, and needs integer weights
+** (see graph_integer_weights) and a queue with maxkey >= radius.
+** dijkstra_search_dheap runs on the DHEAP_ARITY-ary heap, any weights.
+*/
+static inline void
+dial_clear(Dial *q) {
+	while (q->n > 0) {
+		dialRemoveMin(q);
+	}
+	q->cur = 0;
+}
+
+#define DIJKSTRA_NAME         dijkstra_search_heap
+#define DIJKSTRA_QUEUE        Heap
+#define Q_PUSH(q, v, d)       insert(q, v, d)
+#define Q_DECREASE(q, v, d)   changeKey(q, v, d)
+#define Q_PEEK_KEY(q)         peekKey(q)
+#define Q_POP(q)              removeMin(q)
+#define Q_CLEAR(q)            ((q)->n = 0)
+#include "dijkstra_impl.h"
+
+#define DIJKSTRA_NAME         dijkstra_search_dial
+#define DIJKSTRA_QUEUE        Dial
+#define Q_PUSH(q, v, d)       dialInsert(q, v, (int)(d))
+#define Q_DECREASE(q, v, d)   dialChangeKey(q, v, (int)(d))
+#define Q_PEEK_KEY(q)         dialPeekKey(q)
+#define Q_POP(q)              dialRemoveMin(q)
+#define Q_CLEAR(q)            dial_clear(q)
+#include "dijkstra_impl.h"
+
+#define DIJKSTRA_NAME         dijkstra_search_dheap
+#define DIJKSTRA_QUEUE        DHeap
+#define Q_PUSH(q, v, d)       DHeapInsert(q, v, d)
+#define Q_DECREASE(q, v, d)   DHeapChangeKey(q, v, d)
+#define Q_PEEK_KEY(q)         DHeapPeekKey(q)
+#define Q_POP(q)              DHeapRemoveMin(q)
+#define Q_CLEAR(q)            ((q)->n = 0)
+#include "dijkstra_impl.h"
+
+set_t
+*dijkstra_search(Graph *g, Label src, Distance radius, SearchWorkspace *ws,
+                 Distance **settled) {
+	if (ws->dial) {
+		return dijkstra_search_dial(g, src, radius, ws, ws->dial, settled);
+	}
+	if (ws->dheap) {
+		return dijkstra_search_dheap(g, src, radius, ws, ws->dheap, settled);
+	}
+	return dijkstra_search_heap(g, src, radius, ws, ws->heap, settled);
+}
+
+/*
+** Are all edge weights non-negative integers? Distances up to a radius
+** below DIAL_MAX_RADIUS are then exact integers in a Distance, and the
+** bounded searches can use Dial's buckets.
+*/
+int
+graph_integer_weights(Graph *g) {
+	assert(g && g->offsets);
+	for (EdgeIndex i = 0; i < g->num_edges; i++) {
+		Distance w = g->weights[i];
+		if (w < 0 || (w < DIAL_MAX_RADIUS && w != (Distance)(int)w)) {
+			return 0;
 		}
-		// insert into the set
-		s = insert_at_foot(s, u);
 	}
-	destroyHeap(h);
-	return s;
+	return 1;
 }
@@ -1,11 +1,35 @@
 /*
 ** Graph Module - header file
-** Uses an adjacency list representation (arrays for lists).
+** Uses an adjacency list representation (arrays for lists) while the
+** graph is being built, then a frozen compressed sparse row (CSR) form
+** that all of the searches run on.
+**
+** Edge positions in the CSR arrays are EdgeIndex, 32 bits by default and
+** 64 bits when built with EDGE_BITS=64 (make EDGE_BITS=64), for graphs of
+** 2^31 or more directed edges. A frozen graph takes, per directed edge,
+** sizeof(Label) + sizeof(Distance) = 8 bytes, plus sizeof(EdgeIndex) per
+** vertex for the offsets: 4 or 8 bytes, so the wide build costs nothing
+** per edge and 4 bytes more per vertex. Labels stay 32 bits; every
+** module indexes houses and schools with int.
 **
 ** Attributed from Andrew Turpin
 */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
 #define infinity 2147483647
+#define COVER_RADIUS 1000 // metres a school covers along the road network
+#define DIAL_MAX_RADIUS (1 << 22) // largest radius searched with Dial's buckets
+#define GRAPH_NO_EDGE ((Distance)infinity) // length of a free CSR slot, see graph_csr_reserve
 typedef int Label;   // a vertex label (should be numeric to index edge lists)
+#define LABEL_MAX INT32_MAX
+#if EDGE_BITS == 64
+typedef int64_t EdgeIndex; // position of an edge in the CSR arrays
+#define EDGE_INDEX_MAX INT64_MAX
+#else
+typedef int32_t EdgeIndex;
+#define EDGE_INDEX_MAX INT32_MAX
+#endif
 typedef float Distance; // Distance
 typedef int Status; // status of the vertices visited = 1 unvisited = 0
 
@@ -27,6 +51,15 @@ typedef struct {
     int    H;
     int    number_of_vertices; // |V|
     Vertex *vertices;          // array of vertices [0..number_of_vertices-1]
+
+    // CSR form, set up by graph_build_csr(); NULL until then.
+    // the edges of v are [offsets[v], offsets[v+1]) of targets and weights
+    EdgeIndex num_edges;   // total number of (directed) edges, and free slots
+    EdgeIndex *offsets;    // [0..number_of_vertices]
+    Label    *targets;     // [0..num_edges-1] end vertex of each edge
+    Distance *weights;     // [0..num_edges-1] length of each edge
+    void     *mapped;      // if not NULL the CSR arrays live in this file mapping
+    size_t   mapped_bytes; // length of the mapping
 } Graph;
 
 // prototypes
@@ -37,9 +70,14 @@ void  graph_del_edge(Graph *g, Label v, Label u);
 int   graph_has_edge(Graph *g, Label v, Label u);
 Edge *graph_get_edge_array(Graph *g, Label v, int *num_edges);
 void  graph_set_vertex_data(Graph *g, Label v, Status visited);
-void graph_explore(Graph *g, Label v, int *nvertex);
-void graph_dfs(Graph *g, Label v);
-Graph *input_graph(void);
+int  graph_explore(Graph *g, Label v, int *component, int id, Label *stack);
+int  graph_components(Graph *g, int *component);
 int  check_graph(Graph *g, Label v);
+void graph_report_unreachable(Graph *g, Label v, FILE *fp, int limit);
 void graph_print(Graph *g);
 void free_graph(Graph *g);
+void graph_build_csr(Graph *g, EdgeIndex m, const Label *from, const Label *to, const Distance *dist);
+void graph_csr_reserve(Graph *g, Label v, int room);
+EdgeIndex graph_csr_free_slot(Graph *g, Label v);
+size_t graph_csr_bytes(Graph *g);
+int graph_integer_weights(Graph *g);
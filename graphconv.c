@@ -0,0 +1,47 @@
+/*
+** graphconv
+** Converts a graph from the text format (H, S, then "v u dist" lines)
+** to the binary format the solver can map without parsing.
+**
+**   graphconv input.txt output.bin    (input "-" reads stdin)
+**   graphconv -c output.bin           check a binary file's checksum
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "graph.h"
+#include "input.h"
+#include "bingraph.h"
+
+int
+main(int argc, char *argv[]) {
+    Graph *g;
+
+    if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+        g = bingraph_load(argv[2], 1);
+        if (g == NULL) {
+            return EXIT_FAILURE;
+        }
+        printf("%s: ok, %d houses, %d schools, %lld edges\n",
+               argv[2], g->H, g->S, (long long)g->num_edges);
+        free_graph(g);
+        return EXIT_SUCCESS;
+    }
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s input.txt output.bin\n"
+                        "       %s -c output.bin\n", argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    g = strcmp(argv[1], "-") == 0 ? input_graph() : input_graph_file(argv[1]);
+    if (g == NULL) {
+        return EXIT_FAILURE;
+    }
+    if (!bingraph_save(g, argv[2])) {
+        perror(argv[2]);
+        free_graph(g);
+        return EXIT_FAILURE;
+    }
+    free_graph(g);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,494 @@
+/*
+** graphgen
+** Generates connected test graphs of any size, in the text format or the
+** binary one, reproducibly from a seed.
+**
+**   graphgen [-f grid|geo|path] [-n vertices] [-k vertices per school]
+**            [-w edge length] [-d const|uniform|exp|normal] [-j jitter]
+**            [-a degree] [-p keep] [-x seed] [-b] [-o output]
+**
+** Every random choice (a point's position, whether an edge exists, its
+** length, where a school goes) is a hash of the seed and what it is for,
+** so any vertex's edges can be worked out on their own. Nothing the size
+** of the graph is ever held: the text format is written vertex by vertex,
+** and the binary one takes three passes over the vertices, for the
+** offsets, the targets and the weights.
+**
+** Families:
+**   grid  a square street grid; every horizontal street is there and the
+**         first vertical one, each other vertical edge is kept with
+**         probability -p
+**   geo   points spread uniformly over a square, a fixed number per cell
+**         (stratified), joined when closer than the radius that gives
+**         average degree -a; consecutive points are also joined, cells
+**         being numbered in a snake, so the graph is connected
+**   path  a long suburb: a chain, with a shortcut from each vertex to one
+**         a few further along with probability -p
+**
+** Edge lengths are the distance (-w apart on the grid and path, points
+** -w apart on average for geo) times a factor from -d: 1, uniform in
+** 1 +- jitter, exponential with mean 1, or normal with sd jitter.
+** One vertex in each run of -k is a school, at a random place in the run.
+*/
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "graph.h"
+#include "bingraph.h"
+
+#define FAMILY_GRID 0
+#define FAMILY_GEO  1
+#define FAMILY_PATH 2
+
+#define DIST_CONST   0
+#define DIST_UNIFORM 1
+#define DIST_EXP     2
+#define DIST_NORMAL  3
+
+// a path vertex may have a shortcut to one up to this many further on
+#define PATH_REACH 8
+
+// what each hash is for, so different choices never share a value
+#define SALT_X      1
+#define SALT_Y      2
+#define SALT_EDGE   3
+#define SALT_LENGTH 4
+#define SALT_SCHOOL 5
+#define SALT_NORMAL 6
+
+typedef struct {
+    int family, dist;
+    uint64_t seed;
+    int64_t nv;		// vertices, in generation (spatial) order
+    int64_t k;		// one school per run of k vertices
+    double length, jitter, keep;
+    int64_t side;	// grid: vertices per side, geo: cells per side
+    int64_t per_cell;	// geo: points per cell
+    double cell, radius;	// geo: cell side and joining radius
+    int64_t H, S;
+    // the neighbours of the vertex being looked at, with edge lengths
+    int64_t *nbr;
+    Distance *len;
+    int nnbr, maxnbr;
+} gen_t;
+
+/*
+** splitmix64 finaliser over the seed and the three parts of a key
+*/
+static uint64_t
+hash(const gen_t *gen, uint64_t a, uint64_t b, uint64_t salt) {
+    uint64_t z = gen->seed ^ (a * 0x9e3779b97f4a7c15ULL) ^ (b * 0xc2b2ae3d27d4eb4fULL)
+               ^ (salt * 0x165667b19e3779f9ULL);
+    z ^= z >> 30;
+    z *= 0xbf58476d1ce4e5b9ULL;
+    z ^= z >> 27;
+    z *= 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+** Uniform in [0, 1) from a hash
+*/
+static double
+unit(uint64_t h) {
+    return (h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+** The length of edge u-v that is base long before the distribution's
+** factor; the same whichever end asks
+*/
+static Distance
+edge_length(const gen_t *gen, int64_t u, int64_t v, double base) {
+    int64_t a = u < v ? u : v, b = u < v ? v : u;
+    double f = 1, r = unit(hash(gen, a, b, SALT_LENGTH));
+    switch (gen->dist) {
+    case DIST_UNIFORM:
+        f = 1 + gen->jitter * (2 * r - 1);
+        break;
+    case DIST_EXP:
+        f = -log(1 - r);
+        break;
+    case DIST_NORMAL: {
+        double r2 = unit(hash(gen, a, b, SALT_NORMAL));
+        f = 1 + gen->jitter * sqrt(-2 * log(1 - r)) * cos(2 * M_PI * r2);
+        break;
+    }
+    }
+    double w = floor(base * f + 0.5);
+    return w < 1 ? 1 : (Distance)w;
+}
+
+static void
+add_nbr(gen_t *gen, int64_t u, Distance w) {
+    if (gen->nnbr == gen->maxnbr) {
+        gen->maxnbr = gen->maxnbr ? 2 * gen->maxnbr : 16;
+        gen->nbr = (int64_t *)realloc(gen->nbr, sizeof(int64_t) * gen->maxnbr);
+        gen->len = (Distance *)realloc(gen->len, sizeof(Distance) * gen->maxnbr);
+        assert(gen->nbr && gen->len);
+    }
+    gen->nbr[gen->nnbr] = u;
+    gen->len[gen->nnbr] = w;
+    gen->nnbr++;
+}
+
+/*
+** Is the grid edge from v down to v+side there?
+*/
+static int
+grid_down(const gen_t *gen, int64_t v) {
+    return v % gen->side == 0 || unit(hash(gen, v, v + gen->side, SALT_EDGE)) < gen->keep;
+}
+
+/*
+** Does the path have a shortcut from v to v+step?
+*/
+static int
+path_shortcut(const gen_t *gen, int64_t v, int step) {
+    uint64_t h = hash(gen, v, 0, SALT_EDGE);
+    return unit(h) < gen->keep && 2 + (int)((h & 0xffff) % (PATH_REACH - 1)) == step;
+}
+
+/*
+** The cell of geo vertex v, in snake order, and its position
+*/
+static void
+geo_point(const gen_t *gen, int64_t v, double *x, double *y) {
+    int64_t c = v / gen->per_cell, cy = c / gen->side, cx = c % gen->side;
+    if (cy % 2 == 1) {
+        cx = gen->side - 1 - cx;
+    }
+    *x = (cx + unit(hash(gen, v, 0, SALT_X))) * gen->cell;
+    *y = (cy + unit(hash(gen, v, 0, SALT_Y))) * gen->cell;
+}
+
+static int64_t
+geo_cell(const gen_t *gen, int64_t cx, int64_t cy) {
+    return cy * gen->side + (cy % 2 == 1 ? gen->side - 1 - cx : cx);
+}
+
+/*
+** Fill gen's neighbour list with the edges of v (generation order)
+*/
+static void
+neighbours(gen_t *gen, int64_t v) {
+    gen->nnbr = 0;
+    if (gen->family == FAMILY_GRID) {
+        int64_t s = gen->side, x = v % s, y = v / s;
+        if (x > 0) {
+            add_nbr(gen, v - 1, edge_length(gen, v - 1, v, gen->length));
+        }
+        if (x + 1 < s) {
+            add_nbr(gen, v + 1, edge_length(gen, v, v + 1, gen->length));
+        }
+        if (y > 0 && grid_down(gen, v - s)) {
+            add_nbr(gen, v - s, edge_length(gen, v - s, v, gen->length));
+        }
+        if (y + 1 < s && grid_down(gen, v)) {
+            add_nbr(gen, v + s, edge_length(gen, v, v + s, gen->length));
+        }
+    } else if (gen->family == FAMILY_PATH) {
+        if (v > 0) {
+            add_nbr(gen, v - 1, edge_length(gen, v - 1, v, gen->length));
+        }
+        if (v + 1 < gen->nv) {
+            add_nbr(gen, v + 1, edge_length(gen, v, v + 1, gen->length));
+        }
+        for (int step = 2; step <= PATH_REACH; step++) {
+            if (v - step >= 0 && path_shortcut(gen, v - step, step)) {
+                add_nbr(gen, v - step, edge_length(gen, v - step, v, step * gen->length));
+            }
+            if (v + step < gen->nv && path_shortcut(gen, v, step)) {
+                add_nbr(gen, v + step, edge_length(gen, v, v + step, step * gen->length));
+            }
+        }
+    } else {
+        double x, y, ux, uy;
+        geo_point(gen, v, &x, &y);
+        int64_t cx = (int64_t)(x / gen->cell), cy = (int64_t)(y / gen->cell);
+        for (int64_t ny = cy - 1; ny <= cy + 1; ny++) {
+            for (int64_t nx = cx - 1; nx <= cx + 1; nx++) {
+                if (nx < 0 || ny < 0 || nx >= gen->side || ny >= gen->side) {
+                    continue;
+                }
+                int64_t first = geo_cell(gen, nx, ny) * gen->per_cell;
+                for (int64_t u = first; u < first + gen->per_cell; u++) {
+                    if (u == v) {
+                        continue;
+                    }
+                    geo_point(gen, u, &ux, &uy);
+                    double d = hypot(ux - x, uy - y);
+                    // the chain edges join consecutive points whatever their distance
+                    if (d <= gen->radius || u == v - 1 || u == v + 1) {
+                        add_nbr(gen, u, edge_length(gen, u, v, d));
+                    }
+                }
+            }
+        }
+        // a chain neighbour across an empty stretch is not in the 3x3 cells
+        for (int64_t u = v - 1; u <= v + 1; u += 2) {
+            int found = u < 0 || u >= gen->nv;
+            for (int i = 0; i < gen->nnbr && !found; i++) {
+                found = gen->nbr[i] == u;
+            }
+            if (!found) {
+                geo_point(gen, u, &ux, &uy);
+                add_nbr(gen, u, edge_length(gen, u, v, hypot(ux - x, uy - y)));
+            }
+        }
+    }
+}
+
+/*
+** Where the school of run b sits in it
+*/
+static int64_t
+school_offset(const gen_t *gen, int64_t b) {
+    int64_t len = gen->nv - b * gen->k < gen->k ? gen->nv - b * gen->k : gen->k;
+    return hash(gen, b, 0, SALT_SCHOOL) % len;
+}
+
+/*
+** The label of generation vertex v: houses are numbered first, then
+** the schools, each in generation order
+*/
+static int64_t
+label(const gen_t *gen, int64_t v) {
+    int64_t b = v / gen->k, off = school_offset(gen, b), r = v % gen->k;
+    if (r == off) {
+        return gen->H + b;
+    }
+    return v - b - (r > off);
+}
+
+/*
+** The generation vertex of label l, the inverse of label()
+*/
+static int64_t
+vertex(const gen_t *gen, int64_t l) {
+    if (l >= gen->H) {
+        int64_t b = l - gen->H;
+        return b * gen->k + school_offset(gen, b);
+    }
+    int64_t b = l / (gen->k - 1), r = l % (gen->k - 1);
+    return b * gen->k + r + (r >= school_offset(gen, b));
+}
+
+/*
+** Work out the sizes for the family, and how the vertices split into
+** houses and schools
+*/
+static void
+gen_setup(gen_t *gen, int64_t n, double degree) {
+    if (gen->family == FAMILY_GRID) {
+        gen->side = (int64_t)ceil(sqrt((double)n));
+        gen->nv = gen->side * gen->side;
+    } else if (gen->family == FAMILY_PATH) {
+        gen->nv = n;
+    } else {
+        // points are length apart on average over a square of side L,
+        // and joined within the radius that gives them degree neighbours
+        double L = sqrt((double)n) * gen->length;
+        gen->radius = sqrt(degree / (M_PI * n)) * L;
+        gen->side = (int64_t)(L / gen->radius);
+        if (gen->side < 1) {
+            gen->side = 1;
+        }
+        gen->cell = L / gen->side;
+        gen->per_cell = (int64_t)floor((double)n / (gen->side * gen->side) + 0.5);
+        if (gen->per_cell < 1) {
+            gen->per_cell = 1;
+        }
+        gen->nv = gen->side * gen->side * gen->per_cell;
+    }
+    if (gen->k > gen->nv) {
+        gen->k = gen->nv;
+    }
+    gen->S = (gen->nv + gen->k - 1) / gen->k;
+    gen->H = gen->nv - gen->S;
+}
+
+/*
+** Text format: H, S, then each edge once
+*/
+static int
+write_text(gen_t *gen, FILE *fp) {
+    fprintf(fp, "%lld\n%lld\n", (long long)gen->H, (long long)gen->S);
+    for (int64_t v = 0; v < gen->nv; v++) {
+        neighbours(gen, v);
+        int64_t lv = label(gen, v);
+        for (int i = 0; i < gen->nnbr; i++) {
+            if (gen->nbr[i] > v) {
+                fprintf(fp, "%lld %lld %d\n", (long long)lv,
+                        (long long)label(gen, gen->nbr[i]), (int)gen->len[i]);
+            }
+        }
+    }
+    return ferror(fp) == 0;
+}
+
+/*
+** Binary format: the CSR arrays in label order, one pass over the
+** vertices for each array
+*/
+static int
+write_binary(gen_t *gen, const char *filename) {
+    int64_t m = 0;
+    for (int64_t v = 0; v < gen->nv; v++) {
+        neighbours(gen, v);
+        m += gen->nnbr;
+    }
+    if (gen->nv > LABEL_MAX || m > EDGE_INDEX_MAX) {
+        fprintf(stderr, "ERROR! %lld vertices and %lld edges do not fit the binary format%s\n",
+                (long long)gen->nv, (long long)m,
+                gen->nv <= LABEL_MAX ? " (build with EDGE_BITS=64)" : "");
+        return 0;
+    }
+    bingraph_writer_t *w = bingraph_writer_open(filename, (int)gen->H, (int)gen->S, m);
+    if (w == NULL) {
+        return 0;
+    }
+    int ok = 1;
+    EdgeIndex offset = 0;
+    ok = ok && bingraph_writer_put(w, &offset, sizeof(offset));
+    for (int64_t l = 0; l < gen->nv && ok; l++) {
+        neighbours(gen, vertex(gen, l));
+        offset += gen->nnbr;
+        ok = bingraph_writer_put(w, &offset, sizeof(offset));
+    }
+    for (int64_t l = 0; l < gen->nv && ok; l++) {
+        neighbours(gen, vertex(gen, l));
+        for (int i = 0; i < gen->nnbr && ok; i++) {
+            Label t = (Label)label(gen, gen->nbr[i]);
+            ok = bingraph_writer_put(w, &t, sizeof(t));
+        }
+    }
+    for (int64_t l = 0; l < gen->nv && ok; l++) {
+        neighbours(gen, vertex(gen, l));
+        ok = bingraph_writer_put(w, gen->len, sizeof(Distance) * gen->nnbr);
+    }
+    return bingraph_writer_close(w) && ok;
+}
+
+static void
+usage(const char *name) {
+    fprintf(stderr, "usage: %s [-f grid|geo|path] [-n vertices] [-k vertices per school]\n"
+                    "          [-w edge length] [-d const|uniform|exp|normal] [-j jitter]\n"
+                    "          [-a degree] [-p keep] [-x seed] [-b] [-o output]\n", name);
+    exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[]) {
+    gen_t gen;
+    int opt, binary = 0;
+    int64_t n = 100000;
+    double degree = 6;
+    const char *outname = NULL;
+    memset(&gen, 0, sizeof(gen));
+    gen.family = FAMILY_GRID;
+    gen.dist = DIST_UNIFORM;
+    gen.seed = 1;
+    gen.k = 100;
+    gen.length = 100;
+    gen.jitter = 0.3;
+    gen.keep = -1;
+    while ((opt = getopt(argc, argv, "f:n:k:w:d:j:a:p:x:bo:")) != -1) {
+        switch (opt) {
+        case 'f':
+            if (strcmp(optarg, "grid") == 0) {
+                gen.family = FAMILY_GRID;
+            } else if (strcmp(optarg, "geo") == 0) {
+                gen.family = FAMILY_GEO;
+            } else if (strcmp(optarg, "path") == 0) {
+                gen.family = FAMILY_PATH;
+            } else {
+                usage(argv[0]);
+            }
+            break;
+        case 'd':
+            if (strcmp(optarg, "const") == 0) {
+                gen.dist = DIST_CONST;
+            } else if (strcmp(optarg, "uniform") == 0) {
+                gen.dist = DIST_UNIFORM;
+            } else if (strcmp(optarg, "exp") == 0) {
+                gen.dist = DIST_EXP;
+            } else if (strcmp(optarg, "normal") == 0) {
+                gen.dist = DIST_NORMAL;
+            } else {
+                usage(argv[0]);
+            }
+            break;
+        case 'n':
+            n = atoll(optarg);
+            break;
+        case 'k':
+            gen.k = atoll(optarg);
+            break;
+        case 'w':
+            gen.length = atof(optarg);
+            break;
+        case 'j':
+            gen.jitter = atof(optarg);
+            break;
+        case 'a':
+            degree = atof(optarg);
+            break;
+        case 'p':
+            gen.keep = atof(optarg);
+            break;
+        case 'x':
+            gen.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'b':
+            binary = 1;
+            break;
+        case 'o':
+            outname = optarg;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (n < 2 || gen.k < 2 || gen.length <= 0 || degree <= 0) {
+        fprintf(stderr, "ERROR! need at least 2 vertices, runs of at least 2 and "
+                        "positive lengths and degree\n");
+        return EXIT_FAILURE;
+    }
+    if (gen.keep < 0) {
+        // most grid streets go through, and a few path vertices have shortcuts
+        gen.keep = gen.family == FAMILY_PATH ? 0.1 : 0.8;
+    }
+    if (binary && outname == NULL) {
+        fprintf(stderr, "ERROR! -b needs -o, the header is written last\n");
+        return EXIT_FAILURE;
+    }
+    gen_setup(&gen, n, degree);
+
+    int ok;
+    if (binary) {
+        ok = write_binary(&gen, outname);
+    } else {
+        FILE *fp = outname ? fopen(outname, "w") : stdout;
+        if (fp == NULL) {
+            perror(outname);
+            return EXIT_FAILURE;
+        }
+        ok = write_text(&gen, fp);
+        if (outname && fclose(fp) != 0) {
+            ok = 0;
+        }
+    }
+    free(gen.nbr);
+    free(gen.len);
+    if (!ok) {
+        fprintf(stderr, "ERROR! could not write %s\n", outname ? outname : "the graph");
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "%lld houses, %lld schools\n", (long long)gen.H, (long long)gen.S);
+    return EXIT_SUCCESS;
+}
@@ -19,10 +19,29 @@ Heap
     h->map = NULL;
     h->n   = 0;
     h->size= 0;
+    h->nindex = 0;
     
     return h;
 }                               
 
+/*
+** returns a pointer to a new, empty heap whose map is sized up front
+** so that items can be inserted lazily with any dataIndex < nindex,
+** rather than requiring dataIndex 0..n-1 to be inserted in turn
+*/
+Heap
+*createIndexedHeap(uint nindex) {
+    Heap *h = createHeap();
+    h->map = (uint*)malloc(sizeof(uint) * nindex);
+    if (h->map == NULL) {
+        free(h);
+        return NULL;
+    }
+    h->nindex = nindex;
+
+    return h;
+}
+
 /* 
 ** double size of heap.
 ** return 1 on success, 0 on fail
@@ -38,7 +57,8 @@ enlargeHeap(Heap *h) {
         return 0;
     }
 
-    if ((h->map = (uint*)realloc(h->map, sizeof(uint) * h->size * 2)) == NULL) {
+    if (h->nindex == 0 &&
+        (h->map = (uint*)realloc(h->map, sizeof(uint) * h->size * 2)) == NULL) {
         return 0;
     }
 
@@ -191,7 +211,7 @@ destroyHeap(Heap *h) {
     if (h == NULL) {
     	return;
     }
-    if (h->size > 0) {
+    if (h->size > 0 || h->nindex > 0) {
         free(h->map);
         free(h->H);
     }
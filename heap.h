@@ -1,5 +1,8 @@
 /*
 ** Heap/Priority Queue Module - header file
+** Data indices are vertex labels, which stay below LABEL_MAX (2^31 - 1)
+** in every build, so a uint holds any of them and the (uint)-1 given
+** back by an empty heap is never a real index.
 ** Attributed from Andrew Turpin
 */
 typedef unsigned int uint;
@@ -14,12 +17,14 @@ typedef struct heap {
     uint   *map;   // map[i] is index into H of location of payload with dataIndex == i
     uint    n;     // the number of items currently in the heap
     uint    size;  // the maximum number of items allowed in the heap
+    uint    nindex; // if non-zero, map is fixed at nindex entries (any dataIndex < nindex)
 } Heap;
 
 #define HEAP_SUCCESS 1
 #define HEAP_FAIL    0
 
 Heap *createHeap(void);                               // returns a pointer to a new, empty heap
+Heap *createIndexedHeap(uint nindex);                 // new heap that accepts any dataIndex < nindex
 int insert(Heap *h, uint dataIndex, float key);     // inserts dataIndex into h
 uint peek(Heap *h);                                 // returns the data index of the root.
 float peekKey(Heap *h);                              // returns the key of the root.
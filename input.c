@@ -0,0 +1,279 @@
+/*
+** Input Module
+** The whole input is parsed from one buffer, either the memory mapped
+** file or stdin read in large blocks, with a hand-rolled integer scanner
+** in place of scanf. Edges are collected into flat arrays and turned
+** into CSR in one pass, without growing a list per vertex.
+**
+** Every scanning loop stops at a newline or a NUL, so the parser never
+** reads past a buffer that ends in '\n' or is followed by a NUL byte.
+*/
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "graph.h"
+#include "input.h"
+
+#define READ_BLOCK (1 << 20)	// bytes per read() when reading stdin
+
+typedef struct {
+    const char *p;		// next character to scan
+    const char *end;		// one past the last character
+    const char *name;		// input name for error messages
+    int line;			// line number of p
+} scanner_t;
+
+/*
+** Skip spaces and tabs (and the \r of \r\n line ends) on this line,
+** never reading past the end
+*/
+static inline void
+skip_blank(scanner_t *sc) {
+    while (sc->p < sc->end && (*sc->p == ' ' || *sc->p == '\t' || *sc->p == '\r')) {
+        sc->p++;
+    }
+}
+
+// integers are at most this, so any count or label parsed fits a
+// long long with room to add to it
+#define SCAN_INT_MAX (LLONG_MAX / 4)
+
+/*
+** Scan one integer at sc->p into *x.
+** return 1 on success, 0 if there is no integer here or it is too
+** large (sc->p is then left at the digits that overflow)
+*/
+static inline int
+scan_int(scanner_t *sc, long long *x) {
+    const char *p = sc->p;
+    int neg = (*p == '-');
+    p += neg;
+    unsigned d = (unsigned)(*p - '0');
+    if (d > 9) {
+        return 0;
+    }
+    long long v = 0;
+    do {
+        if (v > (SCAN_INT_MAX - d) / 10) {
+            sc->p = p;
+            return 0;
+        }
+        v = v * 10 + d;
+        d = (unsigned)(*++p - '0');
+    } while (d <= 9);
+    sc->p = p;
+    *x = neg ? -v : v;
+    return 1;
+}
+
+/*
+** Report a malformed input line
+*/
+static void
+parse_error(scanner_t *sc, const char *msg) {
+    fprintf(stderr, "ERROR! %s:%d: %s\n", sc->name, sc->line, msg);
+}
+
+/*
+** The header is the first two integers, H then S, which may share a
+** line or sit on lines of their own
+*/
+static int
+scan_header_int(scanner_t *sc, long long *x) {
+    for (;;) {
+        skip_blank(sc);
+        if (sc->p < sc->end && *sc->p == '\n') {
+            sc->p++;
+            sc->line++;
+            continue;
+        }
+        if (sc->p >= sc->end || !scan_int(sc, x)) {
+            parse_error(sc, sc->p < sc->end && *sc->p >= '0' && *sc->p <= '9'
+                            ? "number too large" : "expected the number of houses and schools");
+            return 0;
+        }
+        return 1;
+    }
+}
+
+/*
+** Parse the text format from buf[0..n-1].
+** buf must end in '\n' or be followed by a readable NUL byte.
+*/
+Graph
+*input_graph_buffer(const char *buf, size_t n, const char *name) {
+    scanner_t sc;
+    long long H, S, x[3];
+    EdgeIndex m = 0, cap;
+    int i;
+
+    sc.p = buf;
+    sc.end = buf + n;
+    sc.name = name;
+    sc.line = 1;
+
+    if (!scan_header_int(&sc, &H) || !scan_header_int(&sc, &S)) {
+        return NULL;
+    }
+    if (H < 0 || S < 0 || H + S <= 0 || H + S > LABEL_MAX) {
+        parse_error(&sc, "bad number of houses or schools");
+        return NULL;
+    }
+    int nv = (int)(H + S);
+
+    // roughly one edge per 8 bytes of input to start with
+    cap = (EdgeIndex)(n / 8 < (size_t)EDGE_INDEX_MAX / 4 ? n / 8 : EDGE_INDEX_MAX / 4) + 16;
+    Label *from = (Label *)malloc(sizeof(Label) * cap);
+    Label *to = (Label *)malloc(sizeof(Label) * cap);
+    Distance *dist = (Distance *)malloc(sizeof(Distance) * cap);
+    assert(from && to && dist);
+
+    while (sc.p < sc.end) {
+        skip_blank(&sc);
+        if (sc.p >= sc.end) {
+            break;
+        }
+        if (*sc.p == '\n') {
+            // end of the header line, or a blank line
+            sc.p++;
+            sc.line++;
+            continue;
+        }
+        for (i=0;i<3;i++) {
+            skip_blank(&sc);
+            if (sc.p >= sc.end || !scan_int(&sc, &x[i])) {
+                parse_error(&sc, sc.p < sc.end && *sc.p >= '0' && *sc.p <= '9'
+                                 ? "number too large" : "expected an edge \"v u dist\"");
+                goto fail;
+            }
+        }
+        skip_blank(&sc);
+        if (sc.p < sc.end && *sc.p != '\n') {
+            parse_error(&sc, "unexpected text after edge");
+            goto fail;
+        }
+        if (x[0] < 0 || x[0] >= nv || x[1] < 0 || x[1] >= nv) {
+            parse_error(&sc, "edge vertex out of range");
+            goto fail;
+        }
+        if (x[2] < 0) {
+            parse_error(&sc, "negative edge distance");
+            goto fail;
+        }
+        if (m == cap) {
+            // each edge goes in twice, once from each end
+            if (cap == EDGE_INDEX_MAX / 2) {
+                parse_error(&sc, sizeof(EdgeIndex) == 8 ? "too many edges"
+                                 : "too many edges (build with EDGE_BITS=64)");
+                goto fail;
+            }
+            cap = cap < EDGE_INDEX_MAX / 4 ? cap * 2 : EDGE_INDEX_MAX / 2;
+            from = (Label *)realloc(from, sizeof(Label) * cap);
+            to = (Label *)realloc(to, sizeof(Label) * cap);
+            dist = (Distance *)realloc(dist, sizeof(Distance) * cap);
+            assert(from && to && dist);
+        }
+        from[m] = (Label)x[0];
+        to[m] = (Label)x[1];
+        dist[m] = (Distance)x[2];
+        m++;
+    }
+
+    {
+        Graph *g = graph_new(nv);
+        g->H = (int)H;
+        g->S = (int)S;
+        graph_build_csr(g, m, from, to, dist);
+        free(from);
+        free(to);
+        free(dist);
+        return g;
+    }
+
+fail:
+    free(from);
+    free(to);
+    free(dist);
+    return NULL;
+}
+
+/*
+** Read all of fd into a NUL terminated buffer in large blocks
+*/
+static char
+*read_all(int fd, size_t *n) {
+    size_t size = READ_BLOCK, len = 0;
+    char *buf = (char *)malloc(size + 1);
+    ssize_t r;
+    assert(buf);
+    while ((r = read(fd, buf + len, size - len)) > 0) {
+        len += r;
+        if (len == size) {
+            size *= 2;
+            buf = (char *)realloc(buf, size + 1);
+            assert(buf);
+        }
+    }
+    buf[len] = '\0';
+    *n = len;
+    return buf;
+}
+
+/*
+** Input the the verteces and distances from stdin into the graph structure
+*/
+Graph
+*input_graph(void) {
+    size_t n;
+    char *buf = read_all(STDIN_FILENO, &n);
+    Graph *g = input_graph_buffer(buf, n, "stdin");
+    free(buf);
+    return g;
+}
+
+/*
+** Input the graph from a file, memory mapped when that is safe
+*/
+Graph
+*input_graph_file(const char *filename) {
+    struct stat st;
+    Graph *g;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(filename);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+    size_t n = st.st_size;
+    long page = sysconf(_SC_PAGESIZE);
+
+    // the scanner needs a '\n' last or a NUL after the data; the tail of
+    // a mapping that does not fill its last page reads as zeros
+    if (n > 0 && S_ISREG(st.st_mode)) {
+        char *buf = (char *)mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (buf != MAP_FAILED) {
+            if (n % page != 0 || buf[n-1] == '\n') {
+                madvise(buf, n, MADV_SEQUENTIAL);
+                g = input_graph_buffer(buf, n, filename);
+                munmap(buf, n);
+                close(fd);
+                return g;
+            }
+            munmap(buf, n);
+        }
+    }
+    char *buf = read_all(fd, &n);
+    close(fd);
+    g = input_graph_buffer(buf, n, filename);
+    free(buf);
+    return g;
+}
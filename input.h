@@ -0,0 +1,9 @@
+/*
+** Input Module - header file
+** Reads the text format: the number of houses H and schools S, then one
+** "v u dist" edge per line, and builds the frozen CSR graph directly.
+*/
+
+Graph *input_graph(void);			// read the graph from stdin
+Graph *input_graph_file(const char *filename);	// read (mmap) the graph from a file
+Graph *input_graph_buffer(const char *buf, size_t n, const char *name);
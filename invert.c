@@ -0,0 +1,229 @@
+/*
+** Inverted Coverage Index
+** With the index, choosing a school only touches the schools that share
+** one of the houses it newly covers: each of those loses one unit of
+** gain. Gains live in a bucket queue (one doubly linked list per gain
+** value), so the greedy does O(total coverage size) gain updates rather
+** than re-counting every school every round.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "bitset.h"
+#include "cover.h"
+#include "invert.h"
+#include "stats.h"
+
+/*
+** Build the house -> schools index from the school -> houses sets
+*/
+invert_t
+*invert_build(cover_t **covers, int nset, int H) {
+    int i, j, maxn = 0;
+    invert_t *inv = (invert_t *)malloc(sizeof(*inv));
+    assert(inv);
+    inv->H = H;
+    inv->nset = nset;
+    inv->offsets = (int *)calloc(H + 1, sizeof(int));
+    assert(inv->offsets);
+
+    for (i=0;i<nset;i++) {
+        if (covers[i]->n > maxn) {
+            maxn = covers[i]->n;
+        }
+    }
+    int *houses = (int *)malloc(sizeof(int) * (maxn + 1));
+    assert(houses);
+
+    // count the schools of every house, then place them in school order
+    for (i=0;i<nset;i++) {
+        int n = cover_houses(covers[i], houses);
+        for (j=0;j<n;j++) {
+            inv->offsets[houses[j] + 1]++;
+        }
+    }
+    for (i=0;i<H;i++) {
+        inv->offsets[i + 1] += inv->offsets[i];
+    }
+    inv->schools = (int *)malloc(sizeof(int) * (inv->offsets[H] + 1));
+    int *fill = (int *)malloc(sizeof(int) * (H + 1));
+    assert(inv->schools && fill);
+    for (i=0;i<H;i++) {
+        fill[i] = inv->offsets[i];
+    }
+    for (i=0;i<nset;i++) {
+        int n = cover_houses(covers[i], houses);
+        for (j=0;j<n;j++) {
+            inv->schools[fill[houses[j]]++] = i;
+        }
+    }
+    free(fill);
+    free(houses);
+    return inv;
+}
+
+/*
+** Free the memory allocated to the index
+*/
+void
+invert_free(invert_t *inv) {
+    assert(inv);
+    free(inv->offsets);
+    free(inv->schools);
+    free(inv);
+}
+
+typedef struct {
+    int *head;		// head[g] is the first school with gain g, or -1
+    int *next;		// next/prev link the schools of one bucket
+    int *prev;
+    int *gain;		// current number of uncovered houses of each school
+} buckets_t;
+
+static void
+bucket_unlink(buckets_t *b, int i) {
+    if (b->prev[i] >= 0) {
+        b->next[b->prev[i]] = b->next[i];
+    } else {
+        b->head[b->gain[i]] = b->next[i];
+    }
+    if (b->next[i] >= 0) {
+        b->prev[b->next[i]] = b->prev[i];
+    }
+}
+
+static void
+bucket_link(buckets_t *b, int i) {
+    int g = b->gain[i];
+    b->prev[i] = -1;
+    b->next[i] = b->head[g];
+    if (b->head[g] >= 0) {
+        b->prev[b->head[g]] = i;
+    }
+    b->head[g] = i;
+}
+
+static int
+cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+** Greedy set cover on the inverted index, same answer as cover_greedy().
+** The best gain never grows, and no school can join the top bucket while
+** it is the top, so when a bucket becomes the top its schools are sorted
+** by index once and taken in that order, skipping any that have since
+** dropped to a lower gain. That keeps the lowest index tie breaking.
+*/
+int
+*cover_greedy_bucket(cover_t **covers, int nset, int H, int *num, greedy_stats_t *st) {
+    int *A = (int *)malloc(sizeof(*A) * (nset + 1));
+    char *chosen = (char *)calloc(nset + 1, 1);
+    char *covered = (char *)calloc(H + 1, 1);
+    int *order = (int *)malloc(sizeof(int) * (nset + 1));
+    assert(A && chosen && covered && order);
+    int A_n = 0, count = 0, remaining = H, i, top = 0;
+    long updates = 0;
+
+    invert_t *inv = invert_build(covers, nset, H);
+    buckets_t b;
+    for (i=0;i<nset;i++) {
+        if (covers[i]->n > top) {
+            top = covers[i]->n;
+        }
+    }
+    b.head = (int *)malloc(sizeof(int) * (top + 1));
+    b.next = (int *)malloc(sizeof(int) * (nset + 1));
+    b.prev = (int *)malloc(sizeof(int) * (nset + 1));
+    b.gain = (int *)malloc(sizeof(int) * (nset + 1));
+    int *houses = (int *)malloc(sizeof(int) * (top + 1));
+    assert(b.head && b.next && b.prev && b.gain && houses);
+    for (i=0;i<=top;i++) {
+        b.head[i] = -1;
+    }
+    for (i=nset-1;i>=0;i--) {
+        b.gain[i] = covers[i]->n;
+        bucket_link(&b, i);
+    }
+
+    int norder = 0, next = 0;	// the sorted schools of the top bucket
+    while (remaining > 0 && count < nset) {
+        // take the lowest index school still in the top bucket
+        int index = -1;
+        while (index < 0 && top > 0) {
+            if (next == norder) {
+                // the bucket is used up, sort the next one down
+                if (b.head[top] < 0) {
+                    top--;
+                    continue;
+                }
+                norder = next = 0;
+                for (i=b.head[top];i>=0;i=b.next[i]) {
+                    order[norder++] = i;
+                }
+                qsort(order, norder, sizeof(int), cmp_int);
+            }
+            i = order[next++];
+            if (!chosen[i] && b.gain[i] == top) {
+                index = i;
+            }
+        }
+        if (index < 0) {
+            // nothing left can be covered, see solve_covers
+            break;
+        }
+
+        chosen[index] = 1;
+        bucket_unlink(&b, index);
+        A[A_n++] = covers[index]->school;
+        count++;
+        remaining -= b.gain[index];
+
+        // every other school sharing a newly covered house loses one
+        int n = cover_houses(covers[index], houses);
+        for (int j = 0; j < n; j++) {
+            int h = houses[j];
+            if (covered[h]) {
+                continue;
+            }
+            covered[h] = 1;
+            for (int k = inv->offsets[h]; k < inv->offsets[h + 1]; k++) {
+                int s = inv->schools[k];
+                if (chosen[s]) {
+                    continue;
+                }
+                bucket_unlink(&b, s);
+                b.gain[s]--;
+                bucket_link(&b, s);
+                updates++;
+            }
+        }
+    }
+    // no |S & U| is ever counted here, the gains are kept up to date instead
+    long rounds = count + (remaining > 0 && count < nset);
+    STAT_ADD(STAT_ROUNDS, rounds);
+    if (st) {
+        st->rounds = A_n;
+        st->evaluations = 0;
+        st->saved = rounds * nset;
+        st->updates = updates;
+        st->workers = 1;
+        st->uncovered = remaining;
+    }
+    free(houses);
+    free(b.head);
+    free(b.next);
+    free(b.prev);
+    free(b.gain);
+    invert_free(inv);
+    free(order);
+    free(covered);
+    free(chosen);
+    *num = A_n;
+    return A;
+}
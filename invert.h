@@ -0,0 +1,17 @@
+/*
+** Inverted Coverage Index - header file
+** For every house, the schools whose coverage contains it, in CSR form:
+** the schools (indices into the coverage array) of house h are
+** schools[offsets[h]..offsets[h+1]-1], in ascending order.
+*/
+
+typedef struct {
+    int  H;		// number of houses
+    int  nset;		// number of schools indexed
+    int *offsets;	// [0..H]
+    int *schools;	// [0..offsets[H]-1]
+} invert_t;
+
+invert_t *invert_build(cover_t **covers, int nset, int H);
+void invert_free(invert_t *inv);
+int *cover_greedy_bucket(cover_t **covers, int nset, int H, int *num, greedy_stats_t *st);
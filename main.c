@@ -7,53 +7,494 @@
 */
 #define EXIT_FAILURE 1
 #define EXIT_SUCCESS 0
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <getopt.h>
 #include "graph.h"
 #include "heap.h"
 #include "set.h"
-	
+#include "pool.h"
+#include "input.h"
+#include "bingraph.h"
+#include "solver.h"
+#include "bitset.h"
+#include "cover.h"
+#include "verify.h"
+#include "stats.h"
+#include "dynamic.h"
+#include "server.h"
+#include "reorder.h"
+
+/*
+** Parse a comma separated list of radii into a new array.
+** return the number of radii, 0 if the list is not valid (or a radius is
+** negative or not finite)
+*/
+static int
+parse_radii(const char *list, Distance **radii) {
+    int n = 1;
+    for (const char *p = list; *p; p++) {
+        n += *p == ',';
+    }
+    *radii = (Distance *)malloc(sizeof(Distance) * n);
+    const char *p = list;
+    for (int i = 0; i < n; i++) {
+        char *end;
+        double r = strtod(p, &end);
+        // nan and inf parse too, and so does a number too large for a Distance
+        if (end == p || r < 0 || !isfinite((Distance)r) || (*end != ',' && *end != '\0')) {
+            free(*radii);
+            return 0;
+        }
+        (*radii)[i] = (Distance)r;
+        p = end + 1;
+    }
+    return n;
+}
+
+/*
+** Keep the coverage up to date through the changes in filename ("-" for
+** stdin), one to a line, solving again whenever asked:
+**   add v u dist   a new road v-u
+**   set v u dist   a new length for the road v-u
+**   del v u        no road v-u any more
+**   open i         school i (0 for vertex H) is a candidate again
+**   close i        school i is not a candidate
+**   solve          print "solve k" for the k-th solve, then the cover
+** Blank lines and lines starting with # are skipped, and a line that
+** cannot be applied is reported and skipped.
+** return EXIT_SUCCESS if every line was applied (and every cover verified)
+*/
+static int
+run_updates(Graph *g, const char *filename, Distance radius, int queue, int nworkers,
+            int greedy, int prune, int essential, int stats, int verify) {
+    FILE *fp = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "r");
+    if (fp == NULL) {
+        perror(filename);
+        return EXIT_FAILURE;
+    }
+    double t = stats_now();
+    dynamic_t *d = dynamic_new(g, radius, queue, nworkers);
+    stats_phase_add(PHASE_DIJKSTRA, stats_now() - t);
+
+    int status = EXIT_SUCCESS, lineno = 0, nsolve = 0, nupdates = 0;
+    long searches = 0;
+    double slowest = 0, total = 0;
+    char line[256], cmd[16];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        Label v, u;
+        double dist;
+        int i, n = -1, num = 0;
+        lineno++;
+        if (sscanf(line, "%15s", cmd) != 1 || cmd[0] == '#') {
+            continue;
+        }
+        t = stats_now();
+        if (strcmp(cmd, "solve") == 0) {
+            int *A = dynamic_solve(d, radius, greedy, prune, essential, 0, &num);
+            stats_phase_add(PHASE_COVER, stats_now() - t);
+            fprintf(stdout, "solve %d\n", ++nsolve);
+            for (i=0;i<num;i++) {
+                fprintf(stdout, "%d\n", A[i]-g->H);
+            }
+            fflush(stdout);
+            if (verify) {
+                verify_result_t res;
+                t = stats_now();
+                if (!verify_cover(g, A, num, radius, nworkers, &res)) {
+                    status = EXIT_FAILURE;
+                }
+                stats_phase_add(PHASE_VERIFY, stats_now() - t);
+                verify_report(&res, stderr);
+                verify_result_free(&res);
+            }
+            free(A);
+            continue;
+        }
+        if (strcmp(cmd, "add") == 0 || strcmp(cmd, "set") == 0) {
+            if (sscanf(line, "%*s %d %d %lf", &v, &u, &dist) == 3
+                && dynamic_has_edge(d, v, u) == (cmd[0] == 's')) {
+                n = dynamic_set_edge(d, v, u, (Distance)dist);
+            }
+        } else if (strcmp(cmd, "del") == 0) {
+            if (sscanf(line, "%*s %d %d", &v, &u) == 2) {
+                n = dynamic_del_edge(d, v, u);
+            }
+        } else if (strcmp(cmd, "open") == 0 || strcmp(cmd, "close") == 0) {
+            if (sscanf(line, "%*s %d", &i) == 1) {
+                n = dynamic_set_school(d, i, cmd[0] == 'o');
+            }
+        }
+        if (n < 0) {
+            fprintf(stderr, "ERROR! %s:%d: cannot apply: %s", filename, lineno, line);
+            status = EXIT_FAILURE;
+            continue;
+        }
+        t = stats_now() - t;
+        stats_phase_add(PHASE_UPDATE, t);
+        nupdates++;
+        searches += n;
+        total += t;
+        slowest = t > slowest ? t : slowest;
+    }
+    if (stats) {
+        stats_info("updates", nupdates);
+        stats_info("searches_rerun", searches);
+        stats_info("update_ms_mean", nupdates ? total / nupdates * 1e3 : 0);
+        stats_info("update_ms_max", slowest * 1e3);
+        stats_info("solves", nsolve);
+    }
+    if (fp != stdin) {
+        fclose(fp);
+    }
+    dynamic_free(d);
+    return status;
+}
+
 int 
 main(int argc, char *argv[]) {
     Graph *g;
+    int opt, nworkers = pool_default_workers(), stats = 0, checksum = 0, verify = 0;
+    int status = EXIT_SUCCESS;
+    const char *statsfile = NULL, *updates = NULL, *serve = NULL;
+    double t;
+    int greedy = GREEDY_BUCKET, nradii = 0, prune = 1, essential = 0;
+    int queue = QUEUE_AUTO, order = ORDER_NONE;
+    Distance radius = COVER_RADIUS, *radii = NULL;
+
+    // -t sets the number of threads used to compute the school coverage,
+    // and to scan each round of the bitset greedy
+    // -s reports statistics about the run on stderr as JSON, --stats=file
+    //    writes them to file instead
+    // -c checks the checksum of a binary graph file before using it
+    // -V (--verify) searches again from the chosen schools and reports on
+    //    stderr any house they leave uncovered, failing the run if so
+    // -g picks the greedy set cover: list, bitset, lazy or bucket
+    // -r sets the coverage radius, -R sweeps a comma separated list of them
+    // -n turns off pruning dominated schools before the greedy
+    // -e chooses the schools that are the only cover of a house first
+    // -q picks the search priority queue: heap, dheap or dial (default:
+    //    dial when every weight is an integer, else dheap)
+    // -u applies the road and school changes in a file ("-" for stdin),
+    //    printing a cover at each "solve" in it (see run_updates)
+    // -d answers requests from the coverage kept in memory, on stdin for
+    //    "-" or else on a Unix socket at the path given (see server.h)
+    // -o renumbers the houses for locality before the searches: bfs or
+    //    rcm (see reorder.h); the output is the same either way
+    static const struct option long_options[] = {
+        { "verify", no_argument, NULL, 'V' },
+        { "stats", optional_argument, NULL, 's' },
+        { NULL, 0, NULL, 0 }
+    };
+    while ((opt = getopt_long(argc, argv, "t:scg:r:R:neq:Vu:d:o:", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'q':
+            if (strcmp(optarg, "heap") == 0) {
+                queue = QUEUE_HEAP;
+            } else if (strcmp(optarg, "dheap") == 0) {
+                queue = QUEUE_DHEAP;
+            } else if (strcmp(optarg, "dial") == 0) {
+                queue = QUEUE_DIAL;
+            } else {
+                fprintf(stderr, "ERROR! unknown queue %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'o':
+            if (strcmp(optarg, "bfs") == 0) {
+                order = ORDER_BFS;
+            } else if (strcmp(optarg, "rcm") == 0) {
+                order = ORDER_RCM;
+            } else if (strcmp(optarg, "none") == 0) {
+                order = ORDER_NONE;
+            } else {
+                fprintf(stderr, "ERROR! unknown vertex order %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'n':
+            prune = 0;
+            break;
+        case 'e':
+            essential = 1;
+            break;
+        case 'r':
+            if (parse_radii(optarg, &radii) != 1) {
+                fprintf(stderr, "ERROR! -r needs one finite non-negative radius\n");
+                exit(EXIT_FAILURE);
+            }
+            radius = radii[0];
+            free(radii);
+            radii = NULL;
+            break;
+        case 'R':
+            free(radii);
+            if ((nradii = parse_radii(optarg, &radii)) == 0) {
+                fprintf(stderr, "ERROR! -R needs a list of finite non-negative radii\n");
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'g':
+            if (strcmp(optarg, "list") == 0) {
+                greedy = GREEDY_LIST;
+            } else if (strcmp(optarg, "bitset") == 0) {
+                greedy = GREEDY_BITSET;
+            } else if (strcmp(optarg, "lazy") == 0) {
+                greedy = GREEDY_LAZY;
+            } else if (strcmp(optarg, "bucket") == 0) {
+                greedy = GREEDY_BUCKET;
+            } else {
+                fprintf(stderr, "ERROR! unknown greedy mode %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'c':
+            checksum = 1;
+            break;
+        case 'V':
+            verify = 1;
+            break;
+        case 'u':
+            updates = optarg;
+            break;
+        case 'd':
+            serve = optarg;
+            break;
+        case 's':
+            stats = 1;
+            statsfile = optarg;
+            break;
+        case 't':
+            nworkers = atoi(optarg);
+            if (nworkers < 1) {
+                fprintf(stderr, "ERROR! -t needs a positive thread count\n");
+                exit(EXIT_FAILURE);
+            }
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s | --stats=file] [-c] [-V] [-n] [-e] [-t threads] [-g list|bitset|lazy|bucket] [-q heap|dheap|dial]\n"
+                            "          [-o bfs|rcm] [-r radius | -R radius,radius,...] [-u updates | -d socket|-]\n"
+                            "          [input]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
     
-    //input the data from the file to the graph structure
-    g = input_graph();
+    if ((updates || serve) && nradii > 0) {
+        fprintf(stderr, "ERROR! -u and -d take one radius, not a -R sweep\n");
+        exit(EXIT_FAILURE);
+    }
+    if (optind >= argc && ((updates && strcmp(updates, "-") == 0)
+                           || (serve && strcmp(serve, "-") == 0))) {
+        fprintf(stderr, "ERROR! the graph must come from a file when stdin has requests\n");
+        exit(EXIT_FAILURE);
+    }
+    if (updates && serve) {
+        fprintf(stderr, "ERROR! -u and -d cannot be used together\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((updates || serve) && order != ORDER_NONE) {
+        // their requests name houses and roads by the input's labels
+        fprintf(stderr, "ERROR! -o cannot be used with -u or -d\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    //input the data from the file (or stdin) to the CSR graph structure,
+    //a binary graph file is mapped and used as it is
+    t = stats_now();
+    if (optind >= argc) {
+        g = input_graph();
+    } else if (bingraph_is_file(argv[optind])) {
+        g = bingraph_load(argv[optind], checksum);
+    } else {
+        g = input_graph_file(argv[optind]);
+    }
+    if (g == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    stats_phase_add(PHASE_PARSE, stats_now() - t);
+    if (stats) {
+        stats_info("vertices", g->number_of_vertices);
+        stats_info("edges", g->num_edges);
+        stats_info("csr_bytes", graph_csr_bytes(g));
+        stats_info("threads", nworkers);
+    }
     
     // check if the input is valid and graph is fully connected
     
+    t = stats_now();
     if (!check_graph(g, 0)) {
         fprintf(stderr, "ERROR! The input is invalid\n");
+        graph_report_unreachable(g, 0, stderr, 100);
         exit(EXIT_FAILURE);
     }
+    stats_phase_add(PHASE_CHECK, stats_now() - t);
+    if (order != ORDER_NONE) {
+        if (stats) {
+            stats_info_str("vertex_order", order == ORDER_BFS ? "bfs" : "rcm");
+            stats_info("edge_span_before", reorder_span(g));
+        }
+        t = stats_now();
+        reorder_graph(g, order);
+        stats_phase_add(PHASE_REORDER, stats_now() - t);
+        if (stats) {
+            stats_info("edge_span_after", reorder_span(g));
+        }
+    }
 
-    int i, nset=0;
-    set_t **all_set = (set_t **)malloc(sizeof(set_t*) * g->S);
+    int i, nset=g->S;
+    set_t **all_set = (set_t **)malloc(sizeof(set_t*) * (g->S + 1));
+    Distance **all_dist = NULL;
+    cover_t **covers = NULL;
+    if (nradii > 0) {
+        // a sweep searches once out to the largest radius, recording the
+        // distances, and cuts the sets for the smaller radii from that
+        all_dist = (Distance **)malloc(sizeof(Distance *) * (g->S + 1));
+        radius = radii[0];
+        for (i=1;i<nradii;i++) {
+            if (radii[i] > radius) {
+                radius = radii[i];
+            }
+        }
+    }
     
-    // using dijkstra's SSSP to create sets for each school vertices
-    for (i=g->H;i<g->number_of_vertices;i++) {
-    	    all_set[nset] = dijkstra(g, i);
-    	    nset++;
+    // using dijkstra's SSSP to create sets for each school vertices,
+    // the schools are independent so they are shared among threads
+    if ((queue = choose_queue(g, radius, queue)) < 0) {
+        fprintf(stderr, "ERROR! -q dial needs integer weights and a radius below %d\n",
+                DIAL_MAX_RADIUS);
+        exit(EXIT_FAILURE);
     }
-    // create a set with all house vertices
-    set_t *U = make_empty_set();
-    for (i=0;i<g->H;i++) {
-    	    insert_at_foot(U, i);
+    if (stats) {
+        stats_info_str("search_queue", queue == QUEUE_DIAL ? "dial"
+                       : queue == QUEUE_DHEAP ? "dheap" : "heap");
+    }
+    int nsolve = nradii > 0 ? nradii : 1;
+    if (updates) {
+        // the dynamic module keeps the coverage, and prints the covers
+        status = run_updates(g, updates, radius, queue, nworkers, greedy, prune,
+                             essential, stats, verify);
+        nset = 0;
+        nsolve = 0;
+    } else if (serve) {
+        // the server keeps the coverage, and answers every request
+        t = stats_now();
+        server_t *srv = server_new(g, radius, queue, nworkers, greedy, prune, essential);
+        stats_phase_add(PHASE_DIJKSTRA, stats_now() - t);
+        if (strcmp(serve, "-") == 0) {
+            server_serve(srv, stdin, stdout);
+        } else if (!server_listen(srv, serve)) {
+            status = EXIT_FAILURE;
+        }
+        if (stats) {
+            stats_info("queries", srv->queries);
+            stats_info("query_errors", srv->errors);
+            stats_info("query_ms_mean", srv->queries ? srv->total_ms / srv->queries : 0);
+            stats_info("query_ms_max", srv->max_ms);
+        }
+        server_free(srv);
+        nset = 0;
+        nsolve = 0;
+    } else if (nradii == 0 && greedy != GREEDY_LIST) {
+        // one radius needs no distances or lists, pack each school's
+        // houses as its search finishes
+        covers = (cover_t **)malloc(sizeof(cover_t *) * (g->S + 1));
+        t = stats_now();
+        compute_covers(g, covers, radius, queue, nworkers);
+        stats_phase_add(PHASE_DIJKSTRA, stats_now() - t);
+    } else {
+        t = stats_now();
+        compute_coverage(g, all_set, all_dist, radius, queue, nworkers);
+        stats_phase_add(PHASE_DIJKSTRA, stats_now() - t);
     }
 
     // using set cover algorithm to calculate the school vertices that
-    // cover the largest number of houses
-    
-    int num = 0;
-    int *A = set_cover(all_set, nset, U, &num);
-    
-    // print out the result
-    for (i=0;i<num;i++) {
-    	    fprintf(stdout, "%d\n", A[i]-g->H);
+    // cover the largest number of houses, printing one block per radius
+    // for a sweep
+    for (int r = 0; r < nsolve; r++) {
+        int num = 0;
+        if (nradii > 0) {
+            stats_block(radii[r]);
+        }
+        t = stats_now();
+        int *A;
+        if (covers) {
+            A = solve_covers(covers, nset, g->H, greedy, prune, essential, nworkers, stats,
+                             &num);
+        } else {
+            A = solve_radius(g, all_set, all_dist, nset, nradii > 0 ? radii[r] : radius,
+                             greedy, prune, essential, nworkers, stats, &num);
+        }
+        stats_phase_add(PHASE_COVER, stats_now() - t);
+        t = stats_now();
+        if (nradii > 0) {
+            fprintf(stdout, "radius %g\n", radii[r]);
+        }
+        // print out the result
+        for (i=0;i<num;i++) {
+            fprintf(stdout, "%d\n", A[i]-g->H);
+        }
+        fflush(stdout);
+        stats_phase_add(PHASE_OUTPUT, stats_now() - t);
+        if (stats) {
+            stats_info("cover_size", num);
+        }
+        if (verify) {
+            verify_result_t res;
+            t = stats_now();
+            if (!verify_cover(g, A, num, nradii > 0 ? radii[r] : radius, nworkers, &res)) {
+                status = EXIT_FAILURE;
+            }
+            stats_phase_add(PHASE_VERIFY, stats_now() - t);
+            verify_report(&res, stderr);
+            if (stats) {
+                stats_info("uncovered_houses", res.uncovered);
+            }
+            verify_result_free(&res);
+        }
+        free(A);
+    }
+
+    for (i=0;i<nset;i++) {
+        if (covers) {
+            cover_free(covers[i]);
+            continue;
+        }
+        free_set(all_set[i]);
+        if (all_dist) {
+            free(all_dist[i]);
+        }
+    }
+    free(all_set);
+    free(all_dist);
+    free(covers);
+    free(radii);
+    if (stats) {
+        // every set is freed by now, so these cover the whole run
+        set_stats_t st;
+        set_get_stats(&st);
+        stats_block_end();
+        stats_info("sets", st.sets);
+        stats_info("set_nodes", st.nodes);
+        stats_info("set_mallocs", st.mallocs);
+
+        FILE *fp = statsfile ? fopen(statsfile, "w") : stderr;
+        if (fp == NULL) {
+            perror(statsfile);
+            status = EXIT_FAILURE;
+        } else {
+            stats_report(fp);
+            if (fp != stderr) {
+                fclose(fp);
+            }
+        }
     }
     
     // free the graph
     free_graph(g);
-    return EXIT_SUCCESS;
+    return status;
     
 }
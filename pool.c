@@ -0,0 +1,121 @@
+/*
+** Thread Pool Module
+** Work is handed out from per-worker ranges. A worker claims tasks from
+** the front of its own range with an atomic increment, and when that is
+** empty it claims from the fronts of the other workers' ranges, so every
+** task index is claimed exactly once whichever thread gets it.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pool.h"
+
+typedef struct {
+    volatile int next;		// next unclaimed task in this range
+    int end;			// one past the last task in this range
+    char pad[56];		// keep each range on its own cache line
+} range_t;
+
+typedef struct {
+    range_t *ranges;
+    int nworkers;
+    pool_task_fn fn;
+    void *arg;
+} pool_t;
+
+typedef struct {
+    pool_t *pool;
+    int worker;
+} worker_t;
+
+/*
+** Claim the next task of range r, or return -1 if it is used up
+*/
+static int
+claim(range_t *r) {
+    if (r->next >= r->end) {
+        return -1;
+    }
+    int task = __sync_fetch_and_add(&r->next, 1);
+    return task < r->end ? task : -1;
+}
+
+/*
+** Drain our own range, then steal from the others in turn
+*/
+static void
+*work(void *data) {
+    worker_t *w = (worker_t *)data;
+    pool_t *p = w->pool;
+    int i, task;
+
+    for (i=0;i<p->nworkers;i++) {
+        range_t *r = &p->ranges[(w->worker + i) % p->nworkers];
+        while ((task = claim(r)) >= 0) {
+            p->fn(p->arg, task, w->worker);
+        }
+    }
+    return NULL;
+}
+
+/*
+** Number of cores available to run workers on
+*/
+int
+pool_default_workers(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/*
+** Run fn over tasks 0..ntasks-1 using nworkers threads (the calling
+** thread is worker 0) and return when every task has finished
+*/
+void
+pool_run(int nworkers, int ntasks, pool_task_fn fn, void *arg) {
+    int i;
+    assert(fn);
+    if (nworkers > ntasks) {
+        nworkers = ntasks;
+    }
+    if (nworkers <= 1) {
+        for (i=0;i<ntasks;i++) {
+            fn(arg, i, 0);
+        }
+        return;
+    }
+
+    pool_t p;
+    p.nworkers = nworkers;
+    p.fn = fn;
+    p.arg = arg;
+    p.ranges = (range_t *)malloc(sizeof(range_t) * nworkers);
+    worker_t *w = (worker_t *)malloc(sizeof(worker_t) * nworkers);
+    pthread_t *tid = (pthread_t *)malloc(sizeof(pthread_t) * nworkers);
+    char *started = (char *)malloc(nworkers);
+    assert(p.ranges && w && tid && started);
+
+    // split the tasks into nearly equal contiguous ranges
+    for (i=0;i<nworkers;i++) {
+        p.ranges[i].next = (int)((long)ntasks * i / nworkers);
+        p.ranges[i].end  = (int)((long)ntasks * (i + 1) / nworkers);
+        w[i].pool = &p;
+        w[i].worker = i;
+    }
+    for (i=1;i<nworkers;i++) {
+        // if a thread cannot be started the others steal its range
+        started[i] = pthread_create(&tid[i], NULL, work, &w[i]) == 0;
+    }
+    work(&w[0]);
+    for (i=1;i<nworkers;i++) {
+        if (started[i]) {
+            pthread_join(tid[i], NULL);
+        }
+    }
+    free(started);
+    free(tid);
+    free(w);
+    free(p.ranges);
+}
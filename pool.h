@@ -0,0 +1,12 @@
+/*
+** Thread Pool Module - header file
+** Runs a fixed number of independent tasks over a set of worker threads.
+** Each worker starts with its own contiguous share of the tasks and
+** steals from the other workers' shares once its own runs out.
+*/
+
+// fn(arg, task, worker) is called once for every task in [0, ntasks)
+typedef void (*pool_task_fn)(void *arg, int task, int worker);
+
+int  pool_default_workers(void);	// number of online cores (at least 1)
+void pool_run(int nworkers, int ntasks, pool_task_fn fn, void *arg);
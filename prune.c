@@ -0,0 +1,223 @@
+/*
+** Candidate Pruning
+** A school whose houses are all covered by a lower indexed school can
+** never be the greedy choice: its gain is never larger, and on a tie the
+** lower index wins. Dropping such schools (and exact duplicates) leaves
+** the greedy answer exactly as it was.
+**
+** Subset tests are filtered first on size and on a 64-bit fingerprint of
+** each set (bit h % 64 for every house h), and the only schools tried as
+** a cover of school a are those covering a's rarest house, found from
+** the inverted index.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "bitset.h"
+#include "cset.h"
+#include "cover.h"
+#include "invert.h"
+#include "prune.h"
+
+/*
+** 64-bit fingerprint of a sorted house list
+*/
+static uint64_t
+fingerprint(const int *houses, int n) {
+    uint64_t f = 0;
+    for (int i = 0; i < n; i++) {
+        f |= (uint64_t)1 << (houses[i] & 63);
+    }
+    return f;
+}
+
+/*
+** Is every house of the sorted list a[0..n-1] in b?
+*/
+static int
+subset_of(const int *a, int n, const cover_t *b) {
+    int i;
+    if (b->bits) {
+        for (i = 0; i < n; i++) {
+            if (!bitset_has(b->bits, a[i])) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+    return cset_has_all(b->packed, a, n);
+}
+
+/*
+** The schools that are the only cover of some house in the inverted index
+** inv, setting essential[i] for them if essential is not NULL.
+** return how many there are
+*/
+static int
+count_essential(const invert_t *inv, int nset, int H, char *essential) {
+    int i, n = 0;
+    char *mark = (char *)calloc(nset + 1, 1);
+    assert(mark);
+    for (i=0;i<H;i++) {
+        if (inv->offsets[i+1] - inv->offsets[i] == 1) {
+            int s = inv->schools[inv->offsets[i]];
+            n += !mark[s];
+            mark[s] = 1;
+        }
+    }
+    if (essential) {
+        memcpy(essential, mark, nset);
+    }
+    free(mark);
+    return n;
+}
+
+/*
+** Copy to kept[] (in order) the schools not covered by a lower indexed
+** school. covers[0] is always kept.
+** return the number kept
+*/
+int
+prune_dominated(cover_t **covers, int nset, int H, cover_t **kept, prune_stats_t *st) {
+    int i, k, nkept = 0, maxn = 0;
+    prune_stats_t local;
+    if (st == NULL) {
+        st = &local;
+    }
+    memset(st, 0, sizeof(*st));
+    for (i=0;i<nset;i++) {
+        if (covers[i]->n > maxn) {
+            maxn = covers[i]->n;
+        }
+    }
+
+    invert_t *inv = invert_build(covers, nset, H);
+    uint64_t *fp = (uint64_t *)malloc(sizeof(uint64_t) * (nset + 1));
+    int *houses = (int *)malloc(sizeof(int) * (maxn + 1));
+    assert(fp && houses);
+    for (i=0;i<nset;i++) {
+        int n = cover_houses(covers[i], houses);
+        fp[i] = fingerprint(houses, n);
+    }
+
+    for (i=0;i<nset;i++) {
+        cover_t *a = covers[i];
+        int n = cover_houses(a, houses), by = -1;
+        if (i > 0 && n == 0) {
+            // the empty set is inside school 0's
+            by = 0;
+        }
+        // every cover of a covers its rarest house
+        int rare = -1;
+        for (k = 0; k < n && by < 0; k++) {
+            int h = houses[k];
+            if (rare < 0 || inv->offsets[h+1] - inv->offsets[h]
+                            < inv->offsets[rare+1] - inv->offsets[rare]) {
+                rare = houses[k];
+            }
+        }
+        if (rare >= 0) {
+            // the schools of a house are in ascending order
+            for (k = inv->offsets[rare]; k < inv->offsets[rare+1] && by < 0; k++) {
+                int j = inv->schools[k];
+                if (j >= i) {
+                    break;
+                }
+                if (covers[j]->n < n || (fp[i] & ~fp[j]) != 0) {
+                    continue;
+                }
+                st->subset_tests++;
+                if (subset_of(houses, n, covers[j])) {
+                    by = j;
+                }
+            }
+        }
+        if (by < 0) {
+            kept[nkept++] = a;
+        } else if (covers[by]->n == n) {
+            st->duplicates++;
+        } else {
+            st->dominated++;
+        }
+    }
+    st->essential = count_essential(inv, nset, H, NULL);
+
+    free(houses);
+    free(fp);
+    invert_free(inv);
+    return nkept;
+}
+
+/*
+** Find the schools that are the only cover of some house, setting
+** essential[i] for them if essential is not NULL.
+** return how many there are
+*/
+int
+prune_essential(cover_t **covers, int nset, int H, char *essential) {
+    invert_t *inv = invert_build(covers, nset, H);
+    int n = count_essential(inv, nset, H, essential);
+    invert_free(inv);
+    return n;
+}
+
+/*
+** Force the essential schools into the cover. Their labels go to A (in
+** index order) and the houses they cover are taken out of the problem:
+** rest[] gets the other schools restricted to the remaining houses,
+** renumbered 0..H_rest-1, ready for any of the greedy functions.
+** return the number of essential schools written to A; the number of
+** schools in rest is nset minus that
+*/
+int
+force_essential(cover_t **covers, int nset, int H, cover_t **rest, int *A, int *H_rest) {
+    int i, j, nA = 0, nrest = 0, maxn = 0;
+    char *essential = (char *)malloc(nset + 1);
+    char *covered = (char *)calloc(H + 1, 1);
+    int *newid = (int *)malloc(sizeof(int) * (H + 1));
+    assert(essential && covered && newid);
+    prune_essential(covers, nset, H, essential);
+
+    for (i=0;i<nset;i++) {
+        if (covers[i]->n > maxn) {
+            maxn = covers[i]->n;
+        }
+    }
+    int *houses = (int *)malloc(sizeof(int) * (maxn + 1));
+    assert(houses);
+    for (i=0;i<nset;i++) {
+        if (essential[i]) {
+            A[nA++] = covers[i]->school;
+            int n = cover_houses(covers[i], houses);
+            for (j=0;j<n;j++) {
+                covered[houses[j]] = 1;
+            }
+        }
+    }
+    *H_rest = 0;
+    for (i=0;i<H;i++) {
+        newid[i] = covered[i] ? -1 : (*H_rest)++;
+    }
+    for (i=0;i<nset;i++) {
+        if (essential[i]) {
+            continue;
+        }
+        int n = cover_houses(covers[i], houses), m = 0;
+        for (j=0;j<n;j++) {
+            if (newid[houses[j]] >= 0) {
+                houses[m++] = newid[houses[j]];
+            }
+        }
+        rest[nrest++] = cover_from_houses(houses, m, covers[i]->school, *H_rest);
+    }
+    free(houses);
+    free(newid);
+    free(covered);
+    free(essential);
+    return nA;
+}
@@ -0,0 +1,15 @@
+/*
+** Candidate Pruning - header file
+** Shrinks the list of candidate schools before the greedy set cover.
+*/
+
+typedef struct {
+    int duplicates;	// schools with the same houses as a lower indexed one
+    int dominated;	// schools whose houses are a strict subset of a lower indexed one's
+    int essential;	// schools that are the only cover of some house
+    long subset_tests;	// full subset tests run after the cheap filters
+} prune_stats_t;
+
+int prune_dominated(cover_t **covers, int nset, int H, cover_t **kept, prune_stats_t *st);
+int prune_essential(cover_t **covers, int nset, int H, char *essential);
+int force_essential(cover_t **covers, int nset, int H, cover_t **rest, int *A, int *H_rest);
@@ -0,0 +1,216 @@
+/*
+** qbench
+** Times the bounded searches from every school of a graph with each
+** search priority queue, including the d-ary heap at arities 2, 4 and 8,
+** single threaded.
+**
+**   qbench [-n repeats] [-r radius] graph ...
+*/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "dial.h"
+#include "dheap.h"
+#include "stats.h"
+#include "input.h"
+#include "bingraph.h"
+
+/*
+** The d-ary heaps are instantiated here, one search per arity, so the
+** arities can be compared without compiling them all into the solver
+*/
+DHEAP_DEFINE(DHeap2, Distance, 2)
+DHEAP_DEFINE(DHeap4, Distance, 4)
+DHEAP_DEFINE(DHeap8, Distance, 8)
+
+#define DIJKSTRA_NAME         search_dheap2
+#define DIJKSTRA_QUEUE        DHeap2
+#define Q_PUSH(q, v, d)       DHeap2Insert(q, v, d)
+#define Q_DECREASE(q, v, d)   DHeap2ChangeKey(q, v, d)
+#define Q_PEEK_KEY(q)         DHeap2PeekKey(q)
+#define Q_POP(q)              DHeap2RemoveMin(q)
+#define Q_CLEAR(q)            ((q)->n = 0)
+#include "dijkstra_impl.h"
+
+#define DIJKSTRA_NAME         search_dheap4
+#define DIJKSTRA_QUEUE        DHeap4
+#define Q_PUSH(q, v, d)       DHeap4Insert(q, v, d)
+#define Q_DECREASE(q, v, d)   DHeap4ChangeKey(q, v, d)
+#define Q_PEEK_KEY(q)         DHeap4PeekKey(q)
+#define Q_POP(q)              DHeap4RemoveMin(q)
+#define Q_CLEAR(q)            ((q)->n = 0)
+#include "dijkstra_impl.h"
+
+#define DIJKSTRA_NAME         search_dheap8
+#define DIJKSTRA_QUEUE        DHeap8
+#define Q_PUSH(q, v, d)       DHeap8Insert(q, v, d)
+#define Q_DECREASE(q, v, d)   DHeap8ChangeKey(q, v, d)
+#define Q_PEEK_KEY(q)         DHeap8PeekKey(q)
+#define Q_POP(q)              DHeap8RemoveMin(q)
+#define Q_CLEAR(q)            ((q)->n = 0)
+#include "dijkstra_impl.h"
+
+/*
+** One priority queue under test: how to make one for a graph, run a
+** search on it and free it. create returns NULL if the queue cannot be
+** used for the graph and radius.
+*/
+typedef struct {
+    const char *name;
+    void *(*create)(Graph *g, Distance radius);
+    set_t *(*search)(Graph *g, Label src, Distance radius, void *q, SearchWorkspace *ws);
+    void (*destroy)(void *q);
+} queue_t;
+
+static void *
+heap_create(Graph *g, Distance radius) {
+    return createIndexedHeap(g->number_of_vertices);
+}
+
+static set_t *
+heap_search(Graph *g, Label src, Distance radius, void *q, SearchWorkspace *ws) {
+    return dijkstra_search_heap(g, src, radius, ws, (Heap *)q, NULL);
+}
+
+static void
+heap_destroy(void *q) {
+    destroyHeap((Heap *)q);
+}
+
+static void *
+dial_create(Graph *g, Distance radius) {
+    if (radius >= DIAL_MAX_RADIUS || !graph_integer_weights(g)) {
+        return NULL;
+    }
+    return createDial(g->number_of_vertices, (int)radius);
+}
+
+static set_t *
+dial_search(Graph *g, Label src, Distance radius, void *q, SearchWorkspace *ws) {
+    return dijkstra_search_dial(g, src, radius, ws, (Dial *)q, NULL);
+}
+
+static void
+dial_destroy(void *q) {
+    destroyDial((Dial *)q);
+}
+
+#define DHEAP_QUEUE(Name, search)                                               \
+static void *                                                                   \
+Name##_create(Graph *g, Distance radius) {                                      \
+    return Name##Create(g->number_of_vertices);                                 \
+}                                                                               \
+static set_t *                                                                  \
+Name##_search(Graph *g, Label src, Distance radius, void *q, SearchWorkspace *ws) {  \
+    return search(g, src, radius, ws, (Name *)q, NULL);                       \
+}                                                                               \
+static void                                                                     \
+Name##_destroy(void *q) {                                                       \
+    Name##Destroy((Name *)q);                                                   \
+}
+DHEAP_QUEUE(DHeap2, search_dheap2)
+DHEAP_QUEUE(DHeap4, search_dheap4)
+DHEAP_QUEUE(DHeap8, search_dheap8)
+
+static const queue_t queues[] = {
+    { "heap", heap_create, heap_search, heap_destroy },
+    { "dheap2", DHeap2_create, DHeap2_search, DHeap2_destroy },
+    { "dheap4", DHeap4_create, DHeap4_search, DHeap4_destroy },
+    { "dheap8", DHeap8_create, DHeap8_search, DHeap8_destroy },
+    { "dial", dial_create, dial_search, dial_destroy },
+};
+#define NQUEUES ((int)(sizeof(queues) / sizeof(queues[0])))
+
+/*
+** Run every school's search once on queue q, returning the total number
+** of vertices settled
+*/
+static long
+run_all(Graph *g, Distance radius, const queue_t *qt, void *q, SearchWorkspace *ws) {
+    long settled = 0;
+    for (int i = g->H; i < g->number_of_vertices; i++) {
+        set_t *s = qt->search(g, i, radius, q, ws);
+        settled += s->n;
+        free_set(s);
+    }
+    return settled;
+}
+
+/*
+** Best time of repeats runs, in milliseconds
+*/
+static double
+best_ms(Graph *g, Distance radius, const queue_t *qt, void *q, SearchWorkspace *ws,
+        int repeats, long *settled) {
+    double best = -1;
+    for (int r = 0; r < repeats; r++) {
+        double t = stats_now();
+        *settled = run_all(g, radius, qt, q, ws);
+        t = (stats_now() - t) * 1e3;
+        if (best < 0 || t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+int
+main(int argc, char *argv[]) {
+    int opt, repeats = 5;
+    Distance radius = COVER_RADIUS;
+    while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+        switch (opt) {
+        case 'n':
+            repeats = atoi(optarg) > 0 ? atoi(optarg) : 1;
+            break;
+        case 'r':
+            radius = (Distance)atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n repeats] [-r radius] graph ...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    printf("%-12s %8s %10s", "graph", "schools", "settled");
+    for (int k = 0; k < NQUEUES; k++) {
+        printf(" %7s ms", queues[k].name);
+    }
+    printf("\n");
+    for (int a = optind; a < argc; a++) {
+        Graph *g = bingraph_is_file(argv[a]) ? bingraph_load(argv[a], 0)
+                                             : input_graph_file(argv[a]);
+        if (g == NULL) {
+            return EXIT_FAILURE;
+        }
+        // the distances, the queue under test is passed alongside
+        SearchWorkspace *ws = search_workspace_new(g->number_of_vertices, QUEUE_HEAP, radius);
+        assert(ws);
+        long settled = 0;
+        double ms[NQUEUES];
+        for (int k = 0; k < NQUEUES; k++) {
+            void *q = queues[k].create(g, radius);
+            ms[k] = -1;
+            if (q != NULL) {
+                ms[k] = best_ms(g, radius, &queues[k], q, ws, repeats, &settled);
+                queues[k].destroy(q);
+            }
+        }
+        printf("%-12s %8d %10ld", argv[a], g->S, settled);
+        for (int k = 0; k < NQUEUES; k++) {
+            if (ms[k] < 0) {
+                printf(" %10s", "-");
+            } else {
+                printf(" %10.2f", ms[k]);
+            }
+        }
+        printf("\n");
+        search_workspace_free(ws);
+        free_graph(g);
+    }
+    return EXIT_SUCCESS;
+}
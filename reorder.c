@@ -0,0 +1,241 @@
+/*
+** Reorder Module
+** Both orders are breadth first searches over every vertex, one per
+** component, each started from a pseudo-peripheral vertex: the search
+** is restarted from the lowest degree vertex of its last level while
+** that makes the levels deeper (George and Liu). Cuthill-McKee visits
+** the neighbours of a vertex in increasing degree, and the reverse of
+** its order is the usual choice for a narrow band. The houses are then
+** numbered in the order they come, the schools left where they are.
+** The input has no coordinates, so there is no space filling curve.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include "graph.h"
+#include "reorder.h"
+
+// rounds of looking for a deeper start vertex
+#define PERIPHERAL_ROUNDS 4
+
+static inline int
+degree(const Graph *g, Label v) {
+    return (int)(g->offsets[v+1] - g->offsets[v]);
+}
+
+// for sorting the neighbours of a vertex by degree, then label
+static const Graph *sort_graph;
+
+static int
+cmp_degree(const void *a, const void *b) {
+    Label x = *(const Label *)a, y = *(const Label *)b;
+    int dx = degree(sort_graph, x), dy = degree(sort_graph, y);
+    if (dx != dy) {
+        return dx < dy ? -1 : 1;
+    }
+    return (x > y) - (x < y);
+}
+
+/*
+** Breadth first from start over the vertices not yet marked, appending
+** them to seq from *n on and marking them with stamp. With by_degree
+** the neighbours of each vertex go in by increasing degree.
+** return the number of levels, last is set to the first of the last level
+*/
+static int
+bfs(const Graph *g, Label start, Label *seq, int *n, int *mark, int stamp, int by_degree,
+    int *last) {
+    int head = *n, levels = 0;
+    seq[(*n)++] = start;
+    mark[start] = stamp;
+    while (head < *n) {
+        int end = *n;
+        *last = head;
+        levels++;
+        for (; head < end; head++) {
+            Label v = seq[head];
+            int from = *n;
+            for (EdgeIndex e = g->offsets[v]; e < g->offsets[v+1]; e++) {
+                Label u = g->targets[e];
+                if (mark[u] != stamp) {
+                    mark[u] = stamp;
+                    seq[(*n)++] = u;
+                }
+            }
+            if (by_degree && *n - from > 1) {
+                qsort(seq + from, *n - from, sizeof(Label), cmp_degree);
+            }
+        }
+    }
+    return levels;
+}
+
+/*
+** The order of every vertex for order, as a list of labels
+*/
+static Label
+*visit_order(const Graph *g, int order) {
+    int nv = g->number_of_vertices, n = 0, stamp = 0;
+    Label *seq = (Label *)malloc(sizeof(Label) * (nv + 1));
+    Label *tmp = (Label *)malloc(sizeof(Label) * (nv + 1));
+    int *mark = (int *)calloc(nv + 1, sizeof(int));
+    int *done = (int *)calloc(nv + 1, sizeof(int));
+    assert(seq && tmp && mark && done);
+    sort_graph = g;
+
+    // the vertices by increasing degree, then label, to start each
+    // component from, by counting sort
+    Label *by_degree = (Label *)malloc(sizeof(Label) * (nv + 1));
+    int maxdeg = 0;
+    assert(by_degree);
+    for (Label v = 0; v < nv; v++) {
+        if (degree(g, v) > maxdeg) {
+            maxdeg = degree(g, v);
+        }
+    }
+    int *count = (int *)calloc(maxdeg + 2, sizeof(int));
+    assert(count);
+    for (Label v = 0; v < nv; v++) {
+        count[degree(g, v) + 1]++;
+    }
+    for (int d = 0; d < maxdeg; d++) {
+        count[d + 1] += count[d];
+    }
+    for (Label v = 0; v < nv; v++) {
+        by_degree[count[degree(g, v)]++] = v;
+    }
+    free(count);
+
+    for (int k = 0; k < nv; k++) {
+        Label start = by_degree[k];
+        if (done[start]) {
+            continue;
+        }
+        // look for a start deeper in the component, on scratch marks
+        int m = 0, last, levels = bfs(g, start, tmp, &m, mark, ++stamp, 0, &last);
+        for (int round = 0; round < PERIPHERAL_ROUNDS; round++) {
+            Label best = tmp[last];
+            for (int i = last; i < m; i++) {
+                if (degree(g, tmp[i]) < degree(g, best)) {
+                    best = tmp[i];
+                }
+            }
+            int m2 = 0, last2, levels2 = bfs(g, best, tmp, &m2, mark, ++stamp, 0, &last2);
+            if (levels2 <= levels) {
+                break;
+            }
+            start = best;
+            levels = levels2;
+            m = m2;
+            last = last2;
+        }
+        int from = n;
+        bfs(g, start, seq, &n, done, 1, order == ORDER_RCM, &last);
+        if (order == ORDER_RCM) {
+            for (int i = from, j = n - 1; i < j; i++, j--) {
+                Label t = seq[i];
+                seq[i] = seq[j];
+                seq[j] = t;
+            }
+        }
+    }
+    assert(n == nv);
+    free(by_degree);
+    free(done);
+    free(mark);
+    free(tmp);
+    return seq;
+}
+
+/*
+** Move vertex v of g to new_of[v], rebuilding the CSR arrays
+*/
+static void
+permute(Graph *g, const Label *new_of) {
+    int nv = g->number_of_vertices;
+    Label *old_of = (Label *)malloc(sizeof(Label) * (nv + 1));
+    EdgeIndex *offsets = (EdgeIndex *)malloc(sizeof(EdgeIndex) * (nv + 1));
+    Label *targets = (Label *)malloc(sizeof(Label) * (g->num_edges + 1));
+    Distance *weights = (Distance *)malloc(sizeof(Distance) * (g->num_edges + 1));
+    Vertex *vertices = (Vertex *)malloc(sizeof(Vertex) * nv);
+    assert(old_of && offsets && targets && weights && vertices);
+    for (Label v = 0; v < nv; v++) {
+        old_of[new_of[v]] = v;
+    }
+    // each vertex keeps its edges in the order they were
+    EdgeIndex k = 0;
+    for (Label v = 0; v < nv; v++) {
+        Label old = old_of[v];
+        offsets[v] = k;
+        for (EdgeIndex e = g->offsets[old]; e < g->offsets[old+1]; e++, k++) {
+            Label u = g->targets[e];
+            // a free slot is an edge to itself, and stays one
+            targets[k] = new_of[u];
+            weights[k] = g->weights[e];
+        }
+        vertices[v] = g->vertices[old];
+    }
+    offsets[nv] = k;
+
+    if (g->mapped) {
+        munmap(g->mapped, g->mapped_bytes);
+        g->mapped = NULL;
+        g->mapped_bytes = 0;
+    } else {
+        free(g->offsets);
+        free(g->targets);
+        free(g->weights);
+    }
+    free(g->vertices);
+    g->offsets = offsets;
+    g->targets = targets;
+    g->weights = weights;
+    g->vertices = vertices;
+    free(old_of);
+}
+
+/*
+** Renumber the houses of the frozen graph g in the given order
+*/
+void
+reorder_graph(Graph *g, int order) {
+    assert(g && g->offsets);
+    if (order == ORDER_NONE || g->number_of_vertices == 0) {
+        return;
+    }
+    int nv = g->number_of_vertices, next = 0;
+    Label *seq = visit_order(g, order);
+    Label *new_of = (Label *)malloc(sizeof(Label) * (nv + 1));
+    assert(new_of);
+    for (int i = 0; i < nv; i++) {
+        Label v = seq[i];
+        new_of[v] = v < g->H ? next++ : v;
+    }
+    assert(next == g->H);
+    permute(g, new_of);
+    free(new_of);
+    free(seq);
+}
+
+/*
+** The mean distance between the labels of the two ends of a road
+** between houses, a measure of how far apart in memory the searches
+** have to jump. Roads to schools are left out, the schools do not move.
+*/
+double
+reorder_span(Graph *g) {
+    double sum = 0;
+    long n = 0;
+    assert(g && g->offsets);
+    for (Label v = 0; v < g->H; v++) {
+        for (EdgeIndex e = g->offsets[v]; e < g->offsets[v+1]; e++) {
+            if (g->targets[e] < g->H && g->targets[e] != v) {
+                sum += abs(g->targets[e] - v);
+                n++;
+            }
+        }
+    }
+    return n > 0 ? sum / n : 0;
+}
@@ -0,0 +1,17 @@
+/*
+** Reorder Module - header file
+** Renumbers the houses of a frozen graph so that houses near each other
+** on the road network get labels near each other, and the searches touch
+** fewer cache lines of the CSR arrays, their distances and the queue.
+** Only houses move: they keep the labels [0, H) among themselves and the
+** schools keep theirs, so school indices, the covers chosen and their
+** order are as they were. g->vertices[v].label is the input's label of
+** v, for reporting houses in the input's numbering.
+*/
+
+#define ORDER_NONE 0	// labels as read
+#define ORDER_BFS  1	// breadth first from a peripheral vertex
+#define ORDER_RCM  2	// reverse Cuthill-McKee
+
+void   reorder_graph(Graph *g, int order);
+double reorder_span(Graph *g);		// mean |v - u| over the roads v-u between houses
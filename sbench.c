@@ -0,0 +1,385 @@
+/*
+** sbench
+** Benchmark driver for the whole solver: runs every stage in process on
+** each input, after warmup runs, and reports per-stage medians and
+** percentiles, the cover size and the peak RSS as JSON. Each input is
+** run in a child process of its own, so the peak RSS is that input's
+** and not the largest seen so far. With -b the
+** medians are compared against a stored report, and stages that got
+** slower by more than the threshold are listed on stderr.
+**
+**   sbench [-n repeats] [-w warmup] [-t threads] [-r radius] [-x percent]
+**          [-o report.json] [-b baseline.json] graph ...
+*/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "pool.h"
+#include "input.h"
+#include "bingraph.h"
+#include "bitset.h"
+#include "cover.h"
+#include "solver.h"
+#include "stats.h"
+
+// the stages of a run, as assn2 does them: the phases of stats.h up to
+// the output, then the whole run
+#define PHASE_TOTAL    (PHASE_OUTPUT + 1)
+#define NTIMES         (PHASE_TOTAL + 1)
+
+static const char *phase_name[NTIMES] = {
+    "parse", "check", "dijkstra", "cover", "output", "total"
+};
+
+// changes below this many milliseconds are noise, whatever the ratio
+#define NOISE_MS 0.5
+
+typedef struct {
+    double median, p10, p90, min, max;
+} summary_t;
+
+static int
+cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+** The q-th quantile of the sorted v[0..n-1], interpolating between
+** neighbours
+*/
+static double
+quantile(const double *v, int n, double q) {
+    double pos = q * (n - 1);
+    int i = (int)pos;
+    if (i + 1 >= n) {
+        return v[n - 1];
+    }
+    return v[i] + (pos - i) * (v[i + 1] - v[i]);
+}
+
+static summary_t
+summarise(double *v, int n) {
+    summary_t s;
+    qsort(v, n, sizeof(double), cmp_double);
+    s.median = quantile(v, n, 0.5);
+    s.p10 = quantile(v, n, 0.1);
+    s.p90 = quantile(v, n, 0.9);
+    s.min = v[0];
+    s.max = v[n - 1];
+    return s;
+}
+
+/*
+** One full run over filename, the time of each stage in milliseconds
+** going into ms[]. return the cover size, -1 if the input is unusable
+*/
+static int
+run_once(const char *filename, int nworkers, Distance radius, FILE *out, double *ms,
+         int *nvertices, long long *nedges, size_t *csr_bytes) {
+    double t0 = stats_now(), t;
+    Graph *g = bingraph_is_file(filename) ? bingraph_load(filename, 0)
+                                          : input_graph_file(filename);
+    if (g == NULL) {
+        return -1;
+    }
+    t = stats_now();
+    ms[PHASE_PARSE] = (t - t0) * 1e3;
+
+    if (!check_graph(g, 0)) {
+        fprintf(stderr, "ERROR! %s is not connected\n", filename);
+        free_graph(g);
+        return -1;
+    }
+    ms[PHASE_CHECK] = (stats_now() - t) * 1e3;
+    t = stats_now();
+
+    int queue = choose_queue(g, radius, QUEUE_AUTO);
+    cover_t **covers = (cover_t **)malloc(sizeof(cover_t *) * (g->S + 1));
+    assert(covers);
+    compute_covers(g, covers, radius, queue, nworkers);
+    ms[PHASE_DIJKSTRA] = (stats_now() - t) * 1e3;
+    t = stats_now();
+
+    int num = 0;
+    int *A = solve_covers(covers, g->S, g->H, GREEDY_BUCKET, 1, 0, nworkers, 0, &num);
+    ms[PHASE_COVER] = (stats_now() - t) * 1e3;
+    t = stats_now();
+
+    for (int i = 0; i < num; i++) {
+        fprintf(out, "%d\n", A[i] - g->H);
+    }
+    fflush(out);
+    ms[PHASE_OUTPUT] = (stats_now() - t) * 1e3;
+    ms[PHASE_TOTAL] = (stats_now() - t0) * 1e3;
+
+    *nvertices = g->number_of_vertices;
+    *nedges = g->num_edges;
+    *csr_bytes = graph_csr_bytes(g);
+    for (int i = 0; i < g->S; i++) {
+        cover_free(covers[i]);
+    }
+    free(covers);
+    free(A);
+    free_graph(g);
+    return num;
+}
+
+// what the runs of one input found, besides the times
+typedef struct {
+    int cover, nvertices;
+    long long nedges;
+    size_t csr_bytes;
+} instance_t;
+
+/*
+** Read exactly n bytes from fd. return 1 if they all came
+*/
+static int
+read_full(int fd, void *buf, size_t n) {
+    char *p = (char *)buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r <= 0) {
+            return 0;
+        }
+        p += r;
+        n -= r;
+    }
+    return 1;
+}
+
+static int
+write_full(int fd, const void *buf, size_t n) {
+    const char *p = (const char *)buf;
+    while (n > 0) {
+        ssize_t r = write(fd, p, n);
+        if (r <= 0) {
+            return 0;
+        }
+        p += r;
+        n -= r;
+    }
+    return 1;
+}
+
+/*
+** The warmup and timed runs of filename, in a child process whose peak
+** RSS goes to *peak_kb. The times of run r of phase k go to
+** ms[k * repeats + r]. return 1 if every run went well and gave the same
+** cover size
+*/
+static int
+measure(const char *filename, int nworkers, Distance radius, int warmup, int repeats,
+        FILE *sink, double *ms, instance_t *in, long *peak_kb) {
+    int fds[2];
+    fflush(NULL);
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return 0;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+    if (pid == 0) {
+        double run[NTIMES];
+        close(fds[0]);
+        for (int r = 0; r < warmup + repeats; r++) {
+            int c = run_once(filename, nworkers, radius, sink, run, &in->nvertices,
+                             &in->nedges, &in->csr_bytes);
+            if (c < 0) {
+                _exit(EXIT_FAILURE);
+            }
+            if (r > 0 && c != in->cover) {
+                fprintf(stderr, "ERROR! %s: cover size changed between runs\n", filename);
+                _exit(EXIT_FAILURE);
+            }
+            in->cover = c;
+            if (r >= warmup) {
+                for (int k = 0; k < NTIMES; k++) {
+                    ms[k * repeats + r - warmup] = run[k];
+                }
+            }
+        }
+        int ok = write_full(fds[1], in, sizeof(*in))
+                 && write_full(fds[1], ms, sizeof(double) * NTIMES * repeats);
+        fflush(NULL);
+        _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(fds[1]);
+    int ok = read_full(fds[0], in, sizeof(*in))
+             && read_full(fds[0], ms, sizeof(double) * NTIMES * repeats);
+    close(fds[0]);
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        ok = 0;
+    }
+    *peak_kb = ru.ru_maxrss;
+    return ok;
+}
+
+/*
+** The median of phase for instance name in a report, -1 if it has none.
+** Reports hold one instance per line, as main writes them.
+*/
+static double
+baseline_median(const char *report, const char *name, const char *phase, int *cover) {
+    char key[512];
+    snprintf(key, sizeof(key), "{\"name\": \"%s\",", name);
+    const char *line = strstr(report, key);
+    if (line == NULL) {
+        return -1;
+    }
+    const char *end = strchr(line, '\n');
+    const char *p = strstr(line, "\"cover\": ");
+    if (p != NULL && (end == NULL || p < end)) {
+        *cover = atoi(p + strlen("\"cover\": "));
+    }
+    snprintf(key, sizeof(key), "\"%s\": {\"median_ms\": ", phase);
+    p = strstr(line, key);
+    if (p == NULL || (end != NULL && p > end)) {
+        return -1;
+    }
+    return atof(p + strlen(key));
+}
+
+/*
+** Read a whole file into a new string, NULL if it cannot be read
+*/
+static char *
+read_file(const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long n = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = (char *)malloc(n + 1);
+    assert(buf);
+    n = (long)fread(buf, 1, n, fp);
+    buf[n] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+int
+main(int argc, char *argv[]) {
+    int opt, repeats = 5, warmup = 1, nworkers = pool_default_workers();
+    double threshold = 10;
+    Distance radius = COVER_RADIUS;
+    const char *outname = NULL, *basefile = NULL;
+    while ((opt = getopt(argc, argv, "n:w:t:r:x:o:b:")) != -1) {
+        switch (opt) {
+        case 'n':
+            repeats = atoi(optarg) > 0 ? atoi(optarg) : 1;
+            break;
+        case 'w':
+            warmup = atoi(optarg) > 0 ? atoi(optarg) : 0;
+            break;
+        case 't':
+            nworkers = atoi(optarg) > 0 ? atoi(optarg) : 1;
+            break;
+        case 'r':
+            radius = (Distance)atof(optarg);
+            break;
+        case 'x':
+            threshold = atof(optarg);
+            break;
+        case 'o':
+            outname = optarg;
+            break;
+        case 'b':
+            basefile = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n repeats] [-w warmup] [-t threads] [-r radius] "
+                            "[-x percent]\n              [-o report.json] [-b baseline.json] "
+                            "graph ...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    char *baseline = NULL;
+    if (basefile != NULL && (baseline = read_file(basefile)) == NULL) {
+        fprintf(stderr, "ERROR! cannot read baseline %s\n", basefile);
+        return EXIT_FAILURE;
+    }
+    FILE *report = outname ? fopen(outname, "w") : stdout;
+    FILE *sink = fopen("/dev/null", "w");
+    if (report == NULL || sink == NULL) {
+        fprintf(stderr, "ERROR! cannot open %s\n", report == NULL ? outname : "/dev/null");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(report, "{\n\"repeats\": %d, \"warmup\": %d, \"threads\": %d, \"radius\": %g,\n"
+            "\"pointer_bytes\": %d, \"edge_index_bytes\": %d,\n\"instances\": [\n",
+            repeats, warmup, nworkers, radius, (int)sizeof(void *), (int)sizeof(EdgeIndex));
+    double *ms = (double *)malloc(sizeof(double) * NTIMES * repeats);
+    assert(ms);
+    int regressions = 0;
+    for (int a = optind; a < argc; a++) {
+        instance_t in;
+        long peak_kb = 0;
+        memset(&in, 0, sizeof(in));
+        if (!measure(argv[a], nworkers, radius, warmup, repeats, sink, ms, &in, &peak_kb)) {
+            return EXIT_FAILURE;
+        }
+        int cover = in.cover;
+
+        // one line per instance, so a report can be read back as a baseline
+        fprintf(report, "{\"name\": \"%s\", \"vertices\": %d, \"edges\": %lld, \"cover\": %d, "
+                "\"csr_bytes\": %zu, \"csr_bytes_per_edge\": %.2f, \"peak_rss_kb\": %ld, "
+                "\"phases\": {", argv[a], in.nvertices, in.nedges, cover, in.csr_bytes,
+                in.nedges > 0 ? (double)in.csr_bytes / in.nedges : 0.0, peak_kb);
+        for (int k = 0; k < NTIMES; k++) {
+            summary_t s = summarise(ms + k * repeats, repeats);
+            fprintf(report, "%s\"%s\": {\"median_ms\": %.4f, \"p10_ms\": %.4f, \"p90_ms\": %.4f, "
+                    "\"min_ms\": %.4f, \"max_ms\": %.4f}", k ? ", " : "", phase_name[k],
+                    s.median, s.p10, s.p90, s.min, s.max);
+            if (baseline == NULL) {
+                continue;
+            }
+            int old_cover = cover;
+            double old = baseline_median(baseline, argv[a], phase_name[k], &old_cover);
+            if (k == 0 && old_cover != cover) {
+                fprintf(stderr, "%-12s cover size %d, baseline %d\n", argv[a], cover, old_cover);
+                regressions++;
+            }
+            if (old < 0) {
+                continue;
+            }
+            double change = old > 0 ? (s.median - old) / old * 100 : 0;
+            int slower = change > threshold && s.median - old > NOISE_MS;
+            regressions += slower;
+            fprintf(stderr, "%-12s %-9s %10.3f ms  baseline %10.3f ms  %+7.1f%%%s\n",
+                    argv[a], phase_name[k], s.median, old, change,
+                    slower ? "  REGRESSION" : "");
+        }
+        fprintf(report, "}}%s\n", a + 1 < argc ? "," : "");
+    }
+    fprintf(report, "]\n}\n");
+    if (baseline != NULL) {
+        fprintf(stderr, "%d regression%s over %g%%\n", regressions,
+                regressions == 1 ? "" : "s", threshold);
+    }
+    if (outname) {
+        fclose(report);
+    }
+    fclose(sink);
+    free(ms);
+    free(baseline);
+    return EXIT_SUCCESS;
+}
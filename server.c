@@ -0,0 +1,381 @@
+/*
+** Server Module
+** The searches run once, out to the server's radius, keeping their
+** distances, so the coverage within any smaller radius is a prefix of
+** each. The houses of every school within the radius last asked for are
+** kept as covers, so requests at one radius that differ in the schools
+** allowed go straight to the greedy. Excluded houses are dropped by
+** renumbering the rest, as force_essential does.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "bitset.h"
+#include "cover.h"
+#include "solver.h"
+#include "stats.h"
+#include "server.h"
+
+#define SEPARATORS " \t\r\n"
+
+/*
+** Run the searches for every school of g out to radius and get ready
+** for requests
+*/
+server_t
+*server_new(Graph *g, Distance radius, int queue, int nworkers,
+            int greedy, int prune, int essential) {
+    server_t *s = (server_t *)calloc(1, sizeof(server_t));
+    assert(s);
+    s->g = g;
+    s->radius = radius;
+    s->greedy = greedy;
+    s->prune = prune;
+    s->essential = essential;
+    s->nworkers = nworkers;
+    s->all_set = (set_t **)malloc(sizeof(set_t *) * (g->S + 1));
+    s->all_dist = (Distance **)malloc(sizeof(Distance *) * (g->S + 1));
+    assert(s->all_set && s->all_dist);
+    compute_coverage(g, s->all_set, s->all_dist, radius, queue, nworkers);
+    s->allowed = (int *)calloc(g->S + 1, sizeof(int));
+    s->excluded = (int *)calloc(g->H + 1, sizeof(int));
+    s->cand = (cover_t **)malloc(sizeof(cover_t *) * (g->S + 1));
+    s->newid = (int *)malloc(sizeof(int) * (g->H + 1));
+    s->houses = (int *)malloc(sizeof(int) * (g->H + 1));
+    assert(s->allowed && s->excluded && s->cand && s->newid && s->houses);
+    return s;
+}
+
+static void
+free_covers(server_t *s) {
+    if (s->covers) {
+        for (int i = 0; i < s->g->S; i++) {
+            cover_free(s->covers[i]);
+        }
+        free(s->covers);
+        s->covers = NULL;
+    }
+}
+
+void
+server_free(server_t *s) {
+    if (s == NULL) {
+        return;
+    }
+    free_covers(s);
+    for (int i = 0; i < s->g->S; i++) {
+        free_set(s->all_set[i]);
+        free(s->all_dist[i]);
+    }
+    free(s->all_set);
+    free(s->all_dist);
+    free(s->allowed);
+    free(s->excluded);
+    free(s->cand);
+    free(s->newid);
+    free(s->houses);
+    free(s);
+}
+
+/*
+** Make s->covers the houses of every school within radius
+*/
+static void
+build_covers(server_t *s, Distance radius) {
+    Graph *g = s->g;
+    free_covers(s);
+    s->covers = (cover_t **)malloc(sizeof(cover_t *) * (g->S + 1));
+    assert(s->covers);
+    for (int i = 0; i < g->S; i++) {
+        // the distances are in order, find the first beyond radius
+        int lo = 0, hi = s->all_set[i]->n;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (s->all_dist[i][mid] > radius) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        s->covers[i] = cover_from_prefix(s->all_set[i], lo, g->H + i, g->H);
+    }
+    s->covers_radius = radius;
+}
+
+/*
+** Mark with stamp the indices in list, "a,b,c-d,...", all below n.
+** return 1 if the list is valid
+*/
+static int
+parse_list(const char *list, int *mark, int stamp, int n) {
+    const char *p = list;
+    for (;;) {
+        char *end;
+        long a = strtol(p, &end, 10), b;
+        if (end == p) {
+            return 0;
+        }
+        b = a;
+        if (*end == '-') {
+            p = end + 1;
+            b = strtol(p, &end, 10);
+            if (end == p) {
+                return 0;
+            }
+        }
+        if (a < 0 || b < a || b >= n) {
+            return 0;
+        }
+        for (long k = a; k <= b; k++) {
+            mark[k] = stamp;
+        }
+        if (*end == '\0') {
+            return 1;
+        }
+        if (*end != ',') {
+            return 0;
+        }
+        p = end + 1;
+    }
+}
+
+static int
+request_error(server_t *s, FILE *out, const char *why) {
+    s->errors++;
+    fprintf(out, "error %s\n", why);
+    fflush(out);
+    return SERVER_NEXT;
+}
+
+static void
+record_latency(server_t *s, double ms) {
+    double us = ms * 1e3;
+    int b = us <= 1 ? 0 : (int)(4 * log2(us));
+    s->latency[b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1]++;
+    s->queries++;
+    s->total_ms += ms;
+    if (ms > s->max_ms) {
+        s->max_ms = ms;
+    }
+}
+
+/*
+** The latency in milliseconds that a fraction q of the requests took no
+** longer than, to within a quarter power of two
+*/
+static double
+latency_quantile(server_t *s, double q) {
+    long want = (long)ceil(q * s->queries), seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += s->latency[b];
+        if (seen >= want && seen > 0) {
+            double ms = pow(2, (b + 1) / 4.0) / 1e3;
+            return ms < s->max_ms ? ms : s->max_ms;
+        }
+    }
+    return 0;
+}
+
+/*
+** Answer "solve" with the rest of its line in save
+*/
+static int
+solve_request(server_t *s, char **save, FILE *out, double t0) {
+    Graph *g = s->g;
+    Distance radius = s->radius;
+    int allow = 0, exclude = 0, stamp = ++s->stamp;
+    char *key, *arg;
+    while ((key = strtok_r(NULL, SEPARATORS, save)) != NULL) {
+        if ((arg = strtok_r(NULL, SEPARATORS, save)) == NULL) {
+            return request_error(s, out, "missing value");
+        }
+        if (strcmp(key, "radius") == 0) {
+            char *end;
+            double r = strtod(arg, &end);
+            if (end == arg || *end != '\0' || !(r >= 0) || r > s->radius) {
+                return request_error(s, out, "radius must be from 0 to the server's");
+            }
+            radius = (Distance)r;
+        } else if (strcmp(key, "allow") == 0) {
+            if (!parse_list(arg, s->allowed, stamp, g->S)) {
+                return request_error(s, out, "bad school list");
+            }
+            allow = 1;
+        } else if (strcmp(key, "exclude") == 0) {
+            if (!parse_list(arg, s->excluded, stamp, g->H)) {
+                return request_error(s, out, "bad house list");
+            }
+            exclude = 1;
+        } else {
+            return request_error(s, out, "unknown solve option");
+        }
+    }
+
+    if (s->covers == NULL || radius != s->covers_radius) {
+        build_covers(s, radius);
+    }
+    int i, k, n = 0, H = g->H, num = 0;
+    for (i = 0; i < g->S; i++) {
+        if (!allow || s->allowed[i] == stamp) {
+            s->cand[n++] = s->covers[i];
+        }
+    }
+    if (exclude) {
+        H = 0;
+        for (i = 0; i < g->H; i++) {
+            s->newid[i] = s->excluded[i] == stamp ? -1 : H++;
+        }
+        for (k = 0; k < n; k++) {
+            int m = 0, nh = cover_houses(s->cand[k], s->houses);
+            for (i = 0; i < nh; i++) {
+                if (s->newid[s->houses[i]] >= 0) {
+                    s->houses[m++] = s->newid[s->houses[i]];
+                }
+            }
+            s->cand[k] = cover_from_houses(s->houses, m, s->cand[k]->school, H);
+        }
+    }
+    int *A = solve_covers(s->cand, n, H, s->greedy, s->prune, s->essential, s->nworkers, 0,
+                          &num);
+    if (exclude) {
+        for (k = 0; k < n; k++) {
+            cover_free(s->cand[k]);
+        }
+    }
+
+    double ms = (stats_now() - t0) * 1e3;
+    record_latency(s, ms);
+    fprintf(out, "ok %.3f %d", ms, num);
+    for (i = 0; i < num; i++) {
+        fprintf(out, " %d", A[i] - g->H);
+    }
+    fprintf(out, "\n");
+    fflush(out);
+    free(A);
+    return SERVER_NEXT;
+}
+
+/*
+** Answer one request line (which is cut up doing it).
+** return SERVER_NEXT, or SERVER_QUIT / SERVER_SHUTDOWN when asked to
+*/
+int
+server_request(server_t *s, char *line, FILE *out) {
+    double t0 = stats_now();
+    char *save, *cmd = strtok_r(line, SEPARATORS, &save);
+    if (cmd == NULL || cmd[0] == '#') {
+        return SERVER_NEXT;
+    }
+    if (strcmp(cmd, "solve") == 0) {
+        return solve_request(s, &save, out, t0);
+    }
+    if (strcmp(cmd, "stats") == 0) {
+        fprintf(out, "ok queries %ld errors %ld mean_ms %.3f p50_ms %.3f p99_ms %.3f "
+                "max_ms %.3f\n", s->queries, s->errors,
+                s->queries ? s->total_ms / s->queries : 0.0, latency_quantile(s, 0.5),
+                latency_quantile(s, 0.99), s->max_ms);
+        fflush(out);
+        return SERVER_NEXT;
+    }
+    if (strcmp(cmd, "quit") == 0) {
+        return SERVER_QUIT;
+    }
+    if (strcmp(cmd, "shutdown") == 0) {
+        return SERVER_SHUTDOWN;
+    }
+    return request_error(s, out, "unknown request");
+}
+
+/*
+** Answer the requests from in until quit, shutdown or the end of in.
+** return SERVER_QUIT, or SERVER_SHUTDOWN if asked to
+*/
+int
+server_serve(server_t *s, FILE *in, FILE *out) {
+    char *line = NULL;
+    size_t size = 0;
+    int rc = SERVER_QUIT;
+    while (getline(&line, &size, in) != -1) {
+        if ((rc = server_request(s, line, out)) != SERVER_NEXT) {
+            break;
+        }
+        rc = SERVER_QUIT;
+    }
+    free(line);
+    return rc;
+}
+
+/*
+** Serve the clients of a Unix socket at path one at a time, until one
+** asks for shutdown. return 1 then, 0 if the socket cannot be set up or
+** stops taking clients
+*/
+int
+server_listen(server_t *s, const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "ERROR! socket path %s is too long\n", path);
+        return 0;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(fd, 8) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 0;
+    }
+    // a client that goes away mid answer must not take the server with it
+    signal(SIGPIPE, SIG_IGN);
+
+    int rc = SERVER_QUIT, ok = 1;
+    while (rc != SERVER_SHUTDOWN) {
+        int client = accept(fd, NULL, NULL);
+        if (client < 0) {
+            // a signal or a client that hung up before it was taken is
+            // worth another try, anything else (out of descriptors, say)
+            // would only fail again at once
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            perror(path);
+            ok = 0;
+            break;
+        }
+        int wfd = dup(client);
+        FILE *in = fdopen(client, "r");
+        FILE *out = wfd >= 0 ? fdopen(wfd, "w") : NULL;
+        if (in && out) {
+            rc = server_serve(s, in, out);
+        }
+        if (in) {
+            fclose(in);
+        } else {
+            close(client);
+        }
+        if (out) {
+            fclose(out);
+        } else if (wfd >= 0) {
+            close(wfd);
+        }
+    }
+    close(fd);
+    unlink(path);
+    return ok;
+}
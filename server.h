@@ -0,0 +1,49 @@
+/*
+** Server Module - header file
+** Loads the coverage of every school once and answers what-if requests
+** against it, one line each, from stdin or over a Unix socket:
+**
+**   solve [radius r] [allow list] [exclude list]
+**       the cover at radius r (no larger than the server's), choosing
+**       only from the allowed schools and leaving the excluded houses
+**       out; lists are comma separated indices and ranges a-b, schools
+**       numbered from 0 for vertex H. answers
+**       "ok <ms> <n> <school> ..." with the time the request took
+**   stats    "ok queries <n> errors <n> mean_ms .. p50_ms .. p99_ms .. max_ms .."
+**   quit     end this connection (or the session on stdin)
+**   shutdown stop the server
+**
+** A request that cannot be answered gets "error <why>". Everything a
+** request allocates is freed before the answer, so memory stays flat.
+*/
+
+#define LATENCY_BUCKETS 128	// quarter powers of two of a microsecond
+
+typedef struct {
+    Graph *g;
+    Distance radius;		// the searches ran out to this
+    int greedy, prune, essential;
+    int nworkers;		// for the searches and the greedy's scan
+    set_t **all_set;		// every school's search, as compute_coverage
+    Distance **all_dist;	// gives them
+    struct cover **covers;	// every school's houses within covers_radius,
+    Distance covers_radius;	// kept for the next request at that radius
+    int *allowed, *excluded;	// == stamp if allowed / excluded this request
+    int stamp;
+    struct cover **cand;	// per request scratch
+    int *newid, *houses;
+    long queries, errors;
+    double total_ms, max_ms;
+    long latency[LATENCY_BUCKETS];
+} server_t;
+
+#define SERVER_NEXT     0	// go on reading requests
+#define SERVER_QUIT     1	// the connection is done
+#define SERVER_SHUTDOWN 2	// the server is done
+
+server_t *server_new(Graph *g, Distance radius, int queue, int nworkers,
+                     int greedy, int prune, int essential);
+void server_free(server_t *s);		// the graph is left to the caller
+int  server_request(server_t *s, char *line, FILE *out);
+int  server_serve(server_t *s, FILE *in, FILE *out);	// requests until quit or EOF
+int  server_listen(server_t *s, const char *path);	// a Unix socket, until shutdown
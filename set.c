@@ -10,6 +10,57 @@
 #include "graph.h"
 #include "heap.h"
 #include "set.h"
+#include "stats.h"
+
+// blocks of nodes start small, since most sets are, and double
+#define NODE_BLOCK_FIRST 16
+#define NODE_BLOCK_MAX   65536
+
+struct node_block {
+    node_block_t *next;
+    int size;			// nodes in this block
+};
+
+// totals over freed sets, updated atomically since sets are freed by
+// whichever thread owns them
+static set_stats_t stats;
+
+/*
+** A node for set, from its spare list or its newest block
+*/
+static node_t
+*alloc_node(set_t *set) {
+    node_t *node = set->spare;
+    set->made++;
+    if (node != NULL) {
+        set->spare = node->next;
+        return node;
+    }
+    if (set->room == 0) {
+        int size = set->blocks ? 2 * set->blocks->size : NODE_BLOCK_FIRST;
+        if (size > NODE_BLOCK_MAX) {
+            size = NODE_BLOCK_MAX;
+        }
+        node_block_t *b = (node_block_t *)malloc(sizeof(node_block_t) + sizeof(node_t) * size);
+        assert(b!=NULL);
+        b->next = set->blocks;
+        b->size = size;
+        set->blocks = b;
+        set->room = size;
+    }
+    node = (node_t *)(set->blocks + 1) + (set->blocks->size - set->room);
+    set->room--;
+    return node;
+}
+
+/*
+** Give a node of set back, to be reused by the set's next insertion
+*/
+static void
+release_node(set_t *set, node_t *node) {
+    node->next = set->spare;
+    set->spare = node;
+}
 
 /*
 ** Create an empty set
@@ -21,6 +72,10 @@ set_t
     assert(set!=NULL);
     set->head = set->foot = NULL;
     set->n = 0;
+    set->spare = NULL;
+    set->blocks = NULL;
+    set->room = 0;
+    set->made = 0;
     return set;
 }
 
@@ -38,17 +93,29 @@ is_empty_set(set_t *set) {
 */
 void
 free_set(set_t *set) {
-    node_t *curr, *prev;
+    node_block_t *b, *next;
+    long mallocs = 1;
     assert(set!=NULL);
-    curr = set->head;
-    while (curr) {
-        prev = curr;
-        curr = curr->next;
-        free(prev);
+    // the nodes go with their blocks, without walking the list
+    for (b = set->blocks; b != NULL; b = next) {
+        next = b->next;
+        free(b);
+        mallocs++;
     }
+    __sync_fetch_and_add(&stats.sets, 1);
+    __sync_fetch_and_add(&stats.nodes, set->made);
+    __sync_fetch_and_add(&stats.mallocs, mallocs);
     free(set);
 }
 
+/*
+** Allocation counts over every set freed so far
+*/
+void
+set_get_stats(set_stats_t *st) {
+    *st = stats;
+}
+
 /*
 ** Insert a new node from the head of the set
 */
@@ -56,8 +123,8 @@ free_set(set_t *set) {
 set_t
 *insert_at_head(set_t *set, int value) {
     node_t *new_node;
-    new_node = (node_t*)malloc(sizeof(*new_node));
-    assert(set!=NULL && new_node!=NULL);
+    assert(set!=NULL);
+    new_node = alloc_node(set);
     new_node->data = value;
     new_node->next = set->head;
     set->head = new_node;
@@ -75,8 +142,8 @@ set_t
 set_t
 *insert_at_foot(set_t *set, int value) {
     node_t *new_node;
-    new_node = (node_t*)malloc(sizeof(*new_node));
-    assert(set!=NULL && new_node!=NULL);
+    assert(set!=NULL);
+    new_node = alloc_node(set);
     new_node->data = value;
     new_node->next = NULL;
     if (set->foot==NULL) {
@@ -113,7 +180,7 @@ set_t
         set->foot = NULL;
     }
     set->n--;
-    free(oldhead);
+    release_node(set, oldhead);
     return set;
 }
 
@@ -144,7 +211,7 @@ set_t
             set->foot = curr->next;
     }
     set->n--;
-    free(curr);
+    release_node(set, curr);
 
     return(set);
 }
@@ -165,6 +232,19 @@ is_in_set(set_t *s, int data) {
 }
 
 
+/*
+** The number of elements of s1 that are also in s2, without building
+** the intersection
+*/
+int
+set_count_common(set_t *s1, set_t *s2) {
+	int count = 0;
+	for (node_t *temp = s1->head; temp != NULL; temp = temp->next) {
+		count += is_in_set(s2, temp->data);
+	}
+	return count;
+}
+
 /*
 ** Create a new set with the intersection of data in s1 and s2
 */
@@ -216,7 +296,7 @@ int
 		// school vertices and U is not empty means there are duplicates
 		if (count == nset){
 			*num = A_n;
-			free(U);
+			free_set(U);
 			return A;
 		}
 
@@ -224,13 +304,14 @@ int
 		int max = 0;
 		int index = 0;
 		int i;
+		STAT_ADD(STAT_ROUNDS, 1);
+		STAT_ADD(STAT_INTERSECTIONS, nset);
 		for (i=0;i<nset;i++){
-			set_t *new_s = setIntersect(all_set[i], U);
-			if (new_s->n > max){
-				max = new_s->n;
+			int common = set_count_common(all_set[i], U);
+			if (common > max){
+				max = common;
 				index = i;
 			}
-			free_set(new_s);
 		}
 		// remove elements of the largest uncovered set from U
 		U = setComplement(U, all_set[index]);
@@ -9,12 +9,27 @@ struct node {
     node_t *next;		// the next node connected
 };
 
+// the nodes of a set are carved out of blocks owned by the set, so a
+// set is a handful of mallocs however many elements it has
+typedef struct node_block node_block_t;
+
 typedef struct {
     int n;			// number of items in the set
     node_t *head;		// head node of the set
     node_t *foot;		// foot node of the set
+    node_t *spare;		// deleted nodes, reused before the blocks
+    node_block_t *blocks;	// newest block first
+    int room;			// unused nodes left in blocks
+    int made;			// nodes handed out over the set's life
 } set_t;
 
+// allocation counts over every set freed so far
+typedef struct {
+    long sets;			// sets freed
+    long nodes;			// nodes they used, one malloc each before blocks
+    long mallocs;		// mallocs they actually made, set and blocks
+} set_stats_t;
+
 set_t *make_empty_set(void);	
 int is_empty_set(set_t *set);
 void free_set(set_t *set);
@@ -24,7 +39,42 @@ int get_head(set_t *set);
 set_t *get_tail(set_t *set);
 set_t *delete_element(set_t *set, int value); // added Turpin March 2015
 set_t *dijkstra(Graph *g, Label src);
+
+// priority queues for the bounded searches
+#define QUEUE_AUTO  0		// Dial's buckets when the weights allow, else the d-ary heap
+#define QUEUE_HEAP  1		// binary heap, any weights
+#define QUEUE_DIAL  2		// Dial's buckets, integer weights only
+#define QUEUE_DHEAP 3		// DHEAP_ARITY-ary heap, any weights
+
+// what one thread needs to run bounded searches from many sources: a
+// queue, and distances that are only valid when stamped with the
+// current epoch, so a new search starts without touching all of them
+typedef struct search_workspace {
+    int nvertices;		// searches may run on graphs up to this size
+    int queue;			// QUEUE_HEAP, QUEUE_DIAL or QUEUE_DHEAP
+    struct heap *heap;		// the queue for that kind, the others NULL
+    struct dial *dial;
+    struct DHeap *dheap;
+    Distance *dist;		// dist[v] is the distance of v from the source,
+    unsigned int *stamp;	// if stamp[v] == epoch (v has been reached)
+    unsigned int epoch;
+} SearchWorkspace;
+
+SearchWorkspace *search_workspace_new(int nvertices, int queue, Distance radius);
+void search_workspace_free(SearchWorkspace *ws);
+unsigned int search_workspace_epoch(SearchWorkspace *ws);
+set_t *dijkstra_bounded(Graph *g, Label src, Distance radius, SearchWorkspace *ws);
+set_t *dijkstra_search(Graph *g, Label src, Distance radius, SearchWorkspace *ws,
+                       Distance **settled);
+set_t *dijkstra_search_heap(Graph *g, Label src, Distance radius, SearchWorkspace *ws,
+                            struct heap *q, Distance **settled);
+set_t *dijkstra_search_dial(Graph *g, Label src, Distance radius, SearchWorkspace *ws,
+                            struct dial *q, Distance **settled);
+set_t *dijkstra_search_dheap(Graph *g, Label src, Distance radius, SearchWorkspace *ws,
+                             struct DHeap *q, Distance **settled);
 int is_in_set(set_t *s, int data);
+int set_count_common(set_t *s1, set_t *s2);
+void set_get_stats(set_stats_t *st);
 set_t *setIntersect(set_t *s1, set_t *s2);
 set_t *setComplement(set_t *s1, set_t *s2);
 int *set_cover(set_t **all_set, int n, set_t *U, int *num_sets);
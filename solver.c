@@ -0,0 +1,302 @@
+/*
+** Solver Module
+** The stages of a run after the graph is read, shared by assn2 and the
+** benchmark driver: the bounded searches from every school, and the
+** greedy set cover on their coverage at a radius.
+*/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "pool.h"
+#include "bitset.h"
+#include "cover.h"
+#include "invert.h"
+#include "prune.h"
+#include "solver.h"
+#include "stats.h"
+
+// shared state for the per-school coverage workers
+typedef struct {
+    Graph *g;
+    Distance radius;	// how far the searches go
+    set_t **all_set;	// all_set[i] is the coverage of school vertex H+i
+    Distance **all_dist;	// if not NULL, all_dist[i][k] is the distance of
+			// the k-th element of all_set[i]
+    cover_t **covers;	// if not NULL, all_set is not kept but packed into
+			// covers[i], the houses only
+    SearchWorkspace **ws;	// one search workspace per worker
+} coverage_t;
+
+/*
+** Pool task: compute the coverage set of one school
+*/
+static void
+coverage_task(void *arg, int task, int worker) {
+    coverage_t *c = (coverage_t *)arg;
+    Distance **settled = c->all_dist ? &c->all_dist[task] : NULL;
+    STAT_TIMER(t);
+    set_t *s = dijkstra_search(c->g, c->g->H + task, c->radius, c->ws[worker], settled);
+    if (c->covers) {
+        c->covers[task] = cover_from_set(s, c->g->H + task, c->g->H);
+        free_set(s);
+    } else {
+        c->all_set[task] = s;
+    }
+    STAT_SCHOOL(task, t);
+}
+
+/*
+** Run the searches of c bounded at its radius on nworkers threads, each
+** with its own workspace on the given queue
+*/
+static void
+run_searches(coverage_t *c, int queue, int nworkers) {
+    int i;
+    Graph *g = c->g;
+    if (nworkers > g->S) {
+        nworkers = g->S;
+    }
+    if (nworkers < 1) {
+        nworkers = 1;
+    }
+    STAT_SCHOOLS(g->S);
+    c->ws = (SearchWorkspace **)malloc(sizeof(SearchWorkspace *) * nworkers);
+    assert(c->ws);
+    for (i=0;i<nworkers;i++) {
+        c->ws[i] = search_workspace_new(g->number_of_vertices, queue, c->radius);
+        if (c->ws[i] == NULL) {
+            fprintf(stderr, "ERROR! Out of memory for search workspaces\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    pool_run(nworkers, g->S, coverage_task, c);
+    for (i=0;i<nworkers;i++) {
+        search_workspace_free(c->ws[i]);
+    }
+    free(c->ws);
+}
+
+/*
+** Fill all_set[0..S-1] (and all_dist if not NULL) running the searches
+** bounded at radius on nworkers threads
+*/
+void
+compute_coverage(Graph *g, set_t **all_set, Distance **all_dist, Distance radius,
+                 int queue, int nworkers) {
+    coverage_t c;
+    c.g = g;
+    c.radius = radius;
+    c.all_set = all_set;
+    c.all_dist = all_dist;
+    c.covers = NULL;
+    run_searches(&c, queue, nworkers);
+}
+
+/*
+** As compute_coverage, but each search is packed into covers[i] as soon
+** as it is done and its set freed, so the linked lists of every school
+** are never held at once. For a single radius, where no distances are
+** needed.
+*/
+void
+compute_covers(Graph *g, cover_t **covers, Distance radius, int queue, int nworkers) {
+    coverage_t c;
+    c.g = g;
+    c.radius = radius;
+    c.all_set = NULL;
+    c.all_dist = NULL;
+    c.covers = covers;
+    run_searches(&c, queue, nworkers);
+}
+
+/*
+** A new set holding the first count elements of s
+*/
+static set_t
+*set_prefix(set_t *s, int count) {
+    set_t *p = make_empty_set();
+    node_t *n = s->head;
+    for (int k = 0; k < count; k++, n = n->next) {
+        insert_at_foot(p, n->data);
+    }
+    return p;
+}
+
+/*
+** The queue to run the searches to radius on for a requested kind:
+** QUEUE_AUTO becomes Dial's buckets when every weight is an integer and
+** radius is below DIAL_MAX_RADIUS, else the d-ary heap.
+** return the queue, -1 if QUEUE_DIAL was asked for and cannot be used
+*/
+int
+choose_queue(Graph *g, Distance radius, int queue) {
+    int dial_ok = radius < DIAL_MAX_RADIUS && graph_integer_weights(g);
+    if (queue == QUEUE_DIAL && !dial_ok) {
+        return -1;
+    }
+    if (queue == QUEUE_AUTO) {
+        queue = dial_ok ? QUEUE_DIAL : QUEUE_DHEAP;
+    }
+    return queue;
+}
+
+/*
+** Run the chosen greedy set cover on covers[0..nset-1] over the houses
+** [0, H), dropping dominated schools first if prune and taking the only
+** cover of any house first if essential. GREEDY_LIST needs the linked
+** list sets, so it runs as GREEDY_BITSET here, which chooses the same.
+** GREEDY_BITSET scans each round over up to nworkers threads. If some
+** houses are left that no school covers, covers[0] ends the list as it
+** does for set_cover. The covers are left as they were.
+** return the chosen school vertices, num is set to how many
+*/
+int
+*solve_covers(cover_t **covers, int nset, int H, int greedy, int prune, int essential,
+              int nworkers, int stats, int *num) {
+    cover_t **cand = covers, **kept = NULL, **rest = NULL;
+    int ncand = nset, i;
+    if (stats) {
+        long dense = 0, pairs = 0, bytes = 0;
+        for (i=0;i<nset;i++) {
+            dense += covers[i]->bits != NULL;
+            pairs += covers[i]->n;
+            bytes += cover_bytes(covers[i]);
+        }
+        stats_info("dense_sets", dense);
+        stats_info("sparse_sets", nset - dense);
+        stats_info("covered_pairs", pairs);
+        stats_info("cover_bytes", bytes);
+        stats_info("cover_bytes_per_pair", pairs ? (double)bytes / pairs : 0);
+        stats_info_str("popcount_kernel", bitset_kernel());
+    }
+    // drop the schools the greedy could never choose
+    if (prune) {
+        prune_stats_t pst;
+        kept = (cover_t **)malloc(sizeof(cover_t *) * (nset + 1));
+        ncand = prune_dominated(covers, nset, H, kept, &pst);
+        cand = kept;
+        if (stats) {
+            stats_info("duplicate_schools", pst.duplicates);
+            stats_info("dominated_schools", pst.dominated);
+            stats_info("essential_schools", pst.essential);
+            stats_info("subset_tests", pst.subset_tests);
+        }
+    }
+    // the only cover of some house must be chosen, take those first
+    int nforced = 0, *forced = NULL;
+    if (essential) {
+        rest = (cover_t **)malloc(sizeof(cover_t *) * (ncand + 1));
+        forced = (int *)malloc(sizeof(int) * (ncand + 1));
+        nforced = force_essential(cand, ncand, H, rest, forced, &H);
+        cand = rest;
+        ncand -= nforced;
+    }
+
+    greedy_stats_t st;
+    int *A;
+    if (greedy == GREEDY_BUCKET) {
+        A = cover_greedy_bucket(cand, ncand, H, num, &st);
+    } else if (greedy == GREEDY_LAZY) {
+        A = cover_greedy_lazy(cand, ncand, H, num, &st);
+    } else {
+        A = cover_greedy(cand, ncand, H, nworkers, num, &st);
+    }
+    if (essential) {
+        A = (int *)realloc(A, sizeof(int) * (nforced + *num + 1));
+        memmove(A + nforced, A, sizeof(int) * *num);
+        memcpy(A, forced, sizeof(int) * nforced);
+        *num += nforced;
+        for (i=0;i<ncand;i++) {
+            cover_free(rest[i]);
+        }
+        free(rest);
+        free(forced);
+    }
+    // houses nobody covers are left: set_cover ends on index 0 then, and
+    // that is school 0 of covers whatever pruning and forcing left over
+    if (st.uncovered > 0 && nset > 0) {
+        int found = 0;
+        for (i=0;i<*num;i++) {
+            found |= A[i] == covers[0]->school;
+        }
+        if (!found) {
+            A[(*num)++] = covers[0]->school;
+            st.rounds++;
+        }
+    }
+    free(kept);
+    if (stats) {
+        stats_info("greedy_rounds", st.rounds);
+        stats_info("gain_evaluations", st.evaluations);
+        stats_info("gain_evaluations_saved", st.saved);
+        stats_info("gain_updates", st.updates);
+        stats_info("greedy_workers", st.workers);
+    }
+    return A;
+}
+
+/*
+** Run the chosen greedy set cover on the school coverage within radius.
+** all_set[0..nset-1] are searches out to at least radius, each headed by
+** its school, and if all_dist is not NULL only the prefix within radius
+** is used.
+** With stats, what pruning and the greedy did goes to the stats report.
+** return the chosen school vertices, num is set to how many
+*/
+int
+*solve_radius(Graph *g, set_t **all_set, Distance **all_dist, int nset, Distance radius,
+              int greedy, int prune, int essential, int nworkers, int stats, int *num) {
+    int i;
+    int *A;
+    int *count = (int *)malloc(sizeof(int) * (nset + 1));
+    assert(count);
+    for (i=0;i<nset;i++) {
+        count[i] = all_set[i]->n;
+        if (all_dist) {
+            while (count[i] > 0 && all_dist[i][count[i] - 1] > radius) {
+                count[i]--;
+            }
+        }
+    }
+
+    if (greedy == GREEDY_LIST) {
+        // create a set with all house vertices
+        set_t *U = make_empty_set();
+        for (i=0;i<g->H;i++) {
+            insert_at_foot(U, i);
+        }
+        set_t **sets = all_set;
+        if (all_dist) {
+            sets = (set_t **)malloc(sizeof(set_t *) * (nset + 1));
+            for (i=0;i<nset;i++) {
+                sets[i] = set_prefix(all_set[i], count[i]);
+            }
+        }
+        A = set_cover(sets, nset, U, num);
+        if (all_dist) {
+            for (i=0;i<nset;i++) {
+                free_set(sets[i]);
+            }
+            free(sets);
+        }
+        free(count);
+        return A;
+    }
+
+    // keep only the houses of each set, as a bitset or sorted array
+    cover_t **covers = (cover_t **)malloc(sizeof(cover_t *) * (nset + 1));
+    for (i=0;i<nset;i++) {
+        covers[i] = cover_from_prefix(all_set[i], count[i], all_set[i]->head->data, g->H);
+    }
+    A = solve_covers(covers, nset, g->H, greedy, prune, essential, nworkers, stats, num);
+    for (i=0;i<nset;i++) {
+        cover_free(covers[i]);
+    }
+    free(covers);
+    free(count);
+    return A;
+}
@@ -0,0 +1,18 @@
+/*
+** Solver Module - header file
+*/
+// ways of running the greedy set cover
+#define GREEDY_LIST   0	// set_cover() on the linked list sets
+#define GREEDY_BITSET 1	// cover_greedy() on bitset / sorted array sets
+#define GREEDY_LAZY   2	// cover_greedy_lazy(), re-evaluating only the top gains
+#define GREEDY_BUCKET 3	// cover_greedy_bucket(), gains kept up to date by an inverted index
+
+void compute_coverage(Graph *g, set_t **all_set, Distance **all_dist, Distance radius,
+                      int queue, int nworkers);
+void compute_covers(Graph *g, struct cover **covers, Distance radius, int queue,
+                    int nworkers);
+int choose_queue(Graph *g, Distance radius, int queue);
+int *solve_covers(struct cover **covers, int nset, int H, int greedy, int prune,
+                  int essential, int nworkers, int stats, int *num);
+int *solve_radius(Graph *g, set_t **all_set, Distance **all_dist, int nset, Distance radius,
+                  int greedy, int prune, int essential, int nworkers, int stats, int *num);
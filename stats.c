@@ -0,0 +1,200 @@
+/*
+** Statistics Module
+** Facts are kept in the order they are given, in the block of the radius
+** they were given under, and written out at the end. Nothing here is
+** thread safe except the counters; facts and phases come from the main
+** thread.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+#define SLOWEST   5	// slowest schools listed
+
+typedef struct {
+    const char *key;	// string literals only
+    const char *str;	// NULL for a number
+    double value;
+    int block;		// -1 for the run, else an index into radii
+} fact_t;
+
+static const char *phase_name[NPHASES] = {
+    "parse", "check", "dijkstra", "cover", "output", "verify", "update", "reorder"
+};
+
+static double phases[NPHASES];
+// both grow by doubling, a sweep over many radii adds facts for each
+static fact_t *facts = NULL;
+static int nfacts = 0, facts_size = 0;
+static double *radii = NULL;
+static int nblocks = 0, radii_size = 0;
+static int block = -1;	// where facts go now
+
+#ifdef STATS
+static const char *stat_name[NSTATS] = {
+    "queue_pushes", "queue_pops", "decrease_keys", "edge_relaxations",
+    "vertices_settled", "intersections", "cover_rounds"
+};
+
+long stats_counters[NSTATS];
+static double *school_time = NULL;
+static int nschools = 0;
+#endif
+
+double
+stats_now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+void
+stats_phase_add(int phase, double seconds) {
+    assert(phase >= 0 && phase < NPHASES);
+    phases[phase] += seconds;
+}
+
+static void
+add_fact(const char *key, const char *str, double value) {
+    if (nfacts == facts_size) {
+        facts_size = facts_size ? 2 * facts_size : 64;
+        facts = (fact_t *)realloc(facts, sizeof(*facts) * facts_size);
+        assert(facts);
+    }
+    facts[nfacts].key = key;
+    facts[nfacts].str = str;
+    facts[nfacts].value = value;
+    facts[nfacts].block = block;
+    nfacts++;
+}
+
+void
+stats_info(const char *key, double value) {
+    add_fact(key, NULL, value);
+}
+
+void
+stats_info_str(const char *key, const char *value) {
+    add_fact(key, value, 0);
+}
+
+void
+stats_block(double radius) {
+    if (nblocks == radii_size) {
+        radii_size = radii_size ? 2 * radii_size : 16;
+        radii = (double *)realloc(radii, sizeof(*radii) * radii_size);
+        assert(radii);
+    }
+    radii[nblocks] = radius;
+    block = nblocks++;
+}
+
+void
+stats_block_end(void) {
+    block = -1;
+}
+
+#ifdef STATS
+void
+stats_schools(int n) {
+    free(school_time);
+    school_time = (double *)calloc(n + 1, sizeof(double));
+    assert(school_time);
+    nschools = n;
+}
+
+void
+stats_school_time(int school, double seconds) {
+    if (school >= 0 && school < nschools) {
+        school_time[school] += seconds;
+    }
+}
+
+static int
+cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+#endif
+
+static void
+write_facts(FILE *fp, int block, const char *indent) {
+    for (int i = 0; i < nfacts; i++) {
+        if (facts[i].block != block) {
+            continue;
+        }
+        if (facts[i].str) {
+            fprintf(fp, ",\n%s\"%s\": \"%s\"", indent, facts[i].key, facts[i].str);
+        } else {
+            fprintf(fp, ",\n%s\"%s\": %.15g", indent, facts[i].key, facts[i].value);
+        }
+    }
+}
+
+/*
+** Write everything gathered as one JSON object
+*/
+void
+stats_report(FILE *fp) {
+    int i;
+    fprintf(fp, "{\n  \"phases_ms\": {");
+    for (i = 0; i < NPHASES; i++) {
+        fprintf(fp, "%s\"%s\": %.3f", i ? ", " : "", phase_name[i], phases[i] * 1e3);
+    }
+    fprintf(fp, "}");
+    write_facts(fp, -1, "  ");
+    if (nblocks > 0) {
+        fprintf(fp, ",\n  \"radii\": [");
+        for (int b = 0; b < nblocks; b++) {
+            fprintf(fp, "%s\n    {\"radius\": %g", b ? "," : "", radii[b]);
+            write_facts(fp, b, "     ");
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "\n  ]");
+    }
+#ifdef STATS
+    fprintf(fp, ",\n  \"counters\": {");
+    for (i = 0; i < NSTATS; i++) {
+        fprintf(fp, "%s\"%s\": %ld", i ? ", " : "", stat_name[i], stats_counters[i]);
+    }
+    fprintf(fp, "}");
+    if (nschools > 0) {
+        // the distribution, then the slowest few
+        int top[SLOWEST], ntop = 0, k;
+        for (i = 0; i < nschools; i++) {
+            if (ntop < SLOWEST) {
+                k = ntop++;
+            } else if (school_time[i] > school_time[top[SLOWEST - 1]]) {
+                k = SLOWEST - 1;
+            } else {
+                continue;
+            }
+            for (; k > 0 && school_time[top[k - 1]] < school_time[i]; k--) {
+                top[k] = top[k - 1];
+            }
+            top[k] = i;
+        }
+        double *sorted = (double *)malloc(sizeof(double) * nschools);
+        assert(sorted);
+        memcpy(sorted, school_time, sizeof(double) * nschools);
+        qsort(sorted, nschools, sizeof(double), cmp_double);
+        fprintf(fp, ",\n  \"school_search_ms\": {\"count\": %d, \"min\": %.4f, "
+                "\"median\": %.4f, \"p90\": %.4f, \"max\": %.4f, \"slowest\": [",
+                nschools, sorted[0] * 1e3, sorted[nschools / 2] * 1e3,
+                sorted[(int)(0.9 * (nschools - 1))] * 1e3, sorted[nschools - 1] * 1e3);
+        for (i = 0; i < ntop; i++) {
+            fprintf(fp, "%s{\"school\": %d, \"ms\": %.4f}", i ? ", " : "", top[i],
+                    school_time[top[i]] * 1e3);
+        }
+        fprintf(fp, "]}");
+        free(sorted);
+    }
+#else
+    fprintf(fp, ",\n  \"counters\": null");
+#endif
+    fprintf(fp, "\n}\n");
+}
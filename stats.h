@@ -0,0 +1,58 @@
+/*
+** Statistics Module - header file
+** What a run reports with -s, as one JSON object: facts about the run
+** (sizes, choices, what pruning and the greedy did), the time of each
+** phase, and, in builds with STATS defined, hot path counters and the
+** time of every school's search. Without STATS the counter and school
+** timer macros expand to nothing, so the searches carry no cost.
+*/
+
+// phases of a run, timed with stats_phase_add
+#define PHASE_PARSE    0	// reading the graph
+#define PHASE_CHECK    1	// connectivity check
+#define PHASE_DIJKSTRA 2	// bounded searches from every school
+#define PHASE_COVER    3	// pruning and the greedy set cover
+#define PHASE_OUTPUT   4	// printing the chosen schools
+#define PHASE_VERIFY   5	// -V
+#define PHASE_UPDATE   6	// changes applied with -u
+#define PHASE_REORDER  7	// renumbering the houses with -o
+#define NPHASES        8
+
+// hot path counters, summed over all threads
+#define STAT_PUSHES        0	// vertices put in a search queue
+#define STAT_POPS          1	// vertices taken out of one
+#define STAT_DECREASES     2	// decrease-key calls
+#define STAT_RELAXATIONS   3	// edges looked at from a settled vertex
+#define STAT_SETTLED       4	// vertices settled
+#define STAT_INTERSECTIONS 5	// |S & U| evaluations in the greedy cover
+#define STAT_ROUNDS        6	// greedy cover rounds
+#define NSTATS             7
+
+double stats_now(void);			// monotonic clock, in seconds
+void stats_phase_add(int phase, double seconds);
+void stats_info(const char *key, double value);		// a number for the report
+void stats_info_str(const char *key, const char *value);	// a string for the report
+void stats_block(double radius);	// later facts belong to this radius of a sweep
+void stats_block_end(void);		// and these to the whole run again
+void stats_report(FILE *fp);
+
+#ifdef STATS
+extern long stats_counters[NSTATS];
+void stats_schools(int nschools);		// room for the per-school times
+void stats_school_time(int school, double seconds);
+
+// counters are kept in a local during a search and added in once at the end
+#define STAT_DECL(v)            long v = 0
+#define STAT_INC(v)             ((v)++)
+#define STAT_ADD(c, n)          __sync_fetch_and_add(&stats_counters[c], (long)(n))
+#define STAT_TIMER(t)           double t = stats_now()
+#define STAT_SCHOOL(school, t)  stats_school_time(school, stats_now() - (t))
+#define STAT_SCHOOLS(n)         stats_schools(n)
+#else
+#define STAT_DECL(v)
+#define STAT_INC(v)
+#define STAT_ADD(c, n)
+#define STAT_TIMER(t)
+#define STAT_SCHOOL(school, t)
+#define STAT_SCHOOLS(n)
+#endif
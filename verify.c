@@ -0,0 +1,234 @@
+/*
+** Verify Module
+** Each worker searches from its share of the chosen schools with its own
+** workspace and marks what it reaches in its own bitset; the bitsets are
+** then taken out of the set of all houses, leaving the uncovered ones.
+** The search is a textbook Dijkstra of its own, a binary heap of (distance,
+** vertex) pairs with stale entries skipped, and shares no code with the
+** bounded searches and queues of the solver, so a bug there cannot agree
+** with itself here.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "graph.h"
+#include "heap.h"
+#include "set.h"
+#include "pool.h"
+#include "bitset.h"
+#include "verify.h"
+
+// a vertex and a distance to it, possibly no longer its best
+typedef struct {
+    Distance dist;
+    Label v;
+} reached_t;
+
+// one worker's search state
+typedef struct {
+    Distance *dist;		// infinity where not reached
+    Label *touched;		// the vertices whose dist is set
+    int ntouched;
+    reached_t *heap;
+    int n, size;
+} verify_ws_t;
+
+// shared state for the verifying workers
+typedef struct {
+    Graph *g;
+    const Label *schools;
+    Distance radius;
+    verify_ws_t *ws;		// one per worker
+    bitset_t **covered;		// one per worker, houses reached
+} verify_t;
+
+static int
+cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static void
+heap_push(verify_ws_t *w, Distance dist, Label v) {
+    if (w->n == w->size) {
+        w->size = w->size ? 2 * w->size : 1024;
+        w->heap = (reached_t *)realloc(w->heap, sizeof(reached_t) * w->size);
+        assert(w->heap);
+    }
+    int i = w->n++;
+    while (i > 0 && w->heap[(i - 1) / 2].dist > dist) {
+        w->heap[i] = w->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    w->heap[i].dist = dist;
+    w->heap[i].v = v;
+}
+
+static reached_t
+heap_pop(verify_ws_t *w) {
+    reached_t top = w->heap[0], last = w->heap[--w->n];
+    int i = 0, child;
+    while ((child = 2 * i + 1) < w->n) {
+        if (child + 1 < w->n && w->heap[child + 1].dist < w->heap[child].dist) {
+            child++;
+        }
+        if (w->heap[child].dist >= last.dist) {
+            break;
+        }
+        w->heap[i] = w->heap[child];
+        i = child;
+    }
+    w->heap[i] = last;
+    return top;
+}
+
+/*
+** Pool task: mark the houses one chosen school reaches. Vertices are
+** settled in order of distance until one is further than the radius.
+*/
+static void
+verify_task(void *arg, int task, int worker) {
+    verify_t *v = (verify_t *)arg;
+    verify_ws_t *w = &v->ws[worker];
+    Graph *g = v->g;
+    Label school = v->schools[task];
+    if (school < g->H || school >= g->number_of_vertices) {
+        return;
+    }
+    w->dist[school] = 0;
+    w->touched[w->ntouched++] = school;
+    heap_push(w, 0, school);
+    while (w->n > 0) {
+        reached_t r = heap_pop(w);
+        if (r.dist > w->dist[r.v]) {
+            continue;	// reached more cheaply since
+        }
+        if (r.dist > v->radius) {
+            break;
+        }
+        if (r.v < g->H) {
+            bitset_add(v->covered[worker], r.v);
+        }
+        for (EdgeIndex e = g->offsets[r.v]; e < g->offsets[r.v+1]; e++) {
+            Label u = g->targets[e];
+            Distance d = r.dist + g->weights[e];
+            if (d < w->dist[u]) {
+                if (w->dist[u] == (Distance)infinity) {
+                    w->touched[w->ntouched++] = u;
+                }
+                w->dist[u] = d;
+                heap_push(w, d, u);
+            }
+        }
+    }
+    for (int i = 0; i < w->ntouched; i++) {
+        w->dist[w->touched[i]] = (Distance)infinity;
+    }
+    w->ntouched = 0;
+    w->n = 0;
+}
+
+/*
+** Check that the schools (vertex labels) cover every house within
+** radius, searching on nworkers threads. res gets the details, to be
+** released with verify_result_free.
+** return 1 if every house is covered and every entry is a school
+*/
+int
+verify_cover(Graph *g, const Label *schools, int n, Distance radius, int nworkers,
+             verify_result_t *res) {
+    int i;
+    verify_t v;
+    assert(g && res);
+    if (nworkers > n) {
+        nworkers = n;
+    }
+    if (nworkers < 1) {
+        nworkers = 1;
+    }
+    v.g = g;
+    v.schools = schools;
+    v.radius = radius;
+    v.ws = (verify_ws_t *)calloc(nworkers, sizeof(verify_ws_t));
+    v.covered = (bitset_t **)malloc(sizeof(bitset_t *) * nworkers);
+    assert(v.ws && v.covered);
+    for (i=0;i<nworkers;i++) {
+        int k, nv = g->number_of_vertices;
+        v.ws[i].dist = (Distance *)malloc(sizeof(Distance) * (nv + 1));
+        v.ws[i].touched = (Label *)malloc(sizeof(Label) * (nv + 1));
+        v.covered[i] = bitset_new(g->H);
+        if (v.ws[i].dist == NULL || v.ws[i].touched == NULL || v.covered[i] == NULL) {
+            fprintf(stderr, "ERROR! Out of memory for verification\n");
+            exit(EXIT_FAILURE);
+        }
+        for (k=0;k<nv;k++) {
+            v.ws[i].dist[k] = (Distance)infinity;
+        }
+    }
+    pool_run(nworkers, n, verify_task, &v);
+
+    bitset_t *U = bitset_new(g->H);
+    assert(U);
+    bitset_fill(U);
+    for (i=0;i<nworkers;i++) {
+        bitset_andnot(U, v.covered[i]);
+        bitset_free(v.covered[i]);
+        free(v.ws[i].dist);
+        free(v.ws[i].touched);
+        free(v.ws[i].heap);
+    }
+    free(v.covered);
+    free(v.ws);
+
+    res->schools = n;
+    res->bad_schools = 0;
+    for (i=0;i<n;i++) {
+        res->bad_schools += schools[i] < g->H || schools[i] >= g->number_of_vertices;
+    }
+    res->uncovered = bitset_count(U);
+    // listed by the input's labels, which differ if the houses were renumbered
+    int k = 0, *all = (int *)malloc(sizeof(int) * (res->uncovered + 1));
+    assert(all);
+    for (i=0;i<g->H;i++) {
+        if (bitset_has(U, i)) {
+            all[k++] = g->vertices[i].label;
+        }
+    }
+    qsort(all, k, sizeof(int), cmp_int);
+    res->nhouses = k < VERIFY_MAX_LIST ? k : VERIFY_MAX_LIST;
+    res->houses = (int *)malloc(sizeof(int) * VERIFY_MAX_LIST);
+    assert(res->houses);
+    for (i=0;i<res->nhouses;i++) {
+        res->houses[i] = all[i];
+    }
+    free(all);
+    bitset_free(U);
+    return res->uncovered == 0 && res->bad_schools == 0;
+}
+
+/*
+** Say what verify_cover found
+*/
+void
+verify_report(const verify_result_t *res, FILE *fp) {
+    if (res->bad_schools > 0) {
+        fprintf(fp, "verify: %d of %d entries are not schools\n",
+                res->bad_schools, res->schools);
+    }
+    if (res->uncovered == 0) {
+        fprintf(fp, "verify: ok, %d schools cover every house\n", res->schools);
+        return;
+    }
+    fprintf(fp, "verify: %d houses uncovered:", res->uncovered);
+    for (int i = 0; i < res->nhouses; i++) {
+        fprintf(fp, " %d", res->houses[i]);
+    }
+    fprintf(fp, "%s\n", res->nhouses < res->uncovered ? " ..." : "");
+}
+
+void
+verify_result_free(verify_result_t *res) {
+    free(res->houses);
+    res->houses = NULL;
+}
@@ -0,0 +1,22 @@
+/*
+** Verify Module - header file
+** Checks a solution independently of how it was found: a plain Dijkstra
+** of its own is run from each chosen school and the houses it settles
+** within the radius are ticked off in a bitset.
+*/
+
+// what verify_cover found
+typedef struct {
+    int schools;	// schools checked
+    int bad_schools;	// entries that were not a school vertex
+    int uncovered;	// houses no chosen school reaches within the radius
+    int *houses;	// the first VERIFY_MAX_LIST of them, ascending
+    int nhouses;	// how many are listed
+} verify_result_t;
+
+#define VERIFY_MAX_LIST 100
+
+int  verify_cover(Graph *g, const Label *schools, int n, Distance radius, int nworkers,
+                  verify_result_t *res);	// 1 if every house is covered
+void verify_report(const verify_result_t *res, FILE *fp);
+void verify_result_free(verify_result_t *res);